@@ -256,6 +256,46 @@ static inline unsigned long long __cmpxchg64_mb(volatile void *ptr,
 					 (unsigned long long)(o),	\
 					 (unsigned long long)(n)))
 
+#ifdef CONFIG_HAVE_CMPXCHG_DOUBLE
+/*
+ * Compare and swap two adjacent, doubleword aligned words with a single
+ * LDREXD/STREXD pair. The union keeps the words in memory order, so the
+ * same code works on either endianness.
+ */
+static inline int __cmpxchg_double(volatile void *ptr,
+				   unsigned long old1, unsigned long old2,
+				   unsigned long new1, unsigned long new2)
+{
+	union {
+		unsigned long w[2];
+		unsigned long long d;
+	} old = { .w = { old1, old2 } }, new = { .w = { new1, new2 } };
+
+	return __cmpxchg64(ptr, old.d, new.d) == old.d;
+}
+
+#define system_has_cmpxchg_double()	1
+
+#define cmpxchg_double_local(p1, p2, o1, o2, n1, n2)			\
+({									\
+	BUILD_BUG_ON(sizeof(*(p1)) != sizeof(long));			\
+	BUILD_BUG_ON(sizeof(*(p2)) != sizeof(long));			\
+	VM_BUG_ON((unsigned long)(p1) % (2 * sizeof(long)));		\
+	VM_BUG_ON((unsigned long)((p1) + 1) != (unsigned long)(p2));	\
+	__cmpxchg_double((p1), (unsigned long)(o1), (unsigned long)(o2),\
+			 (unsigned long)(n1), (unsigned long)(n2));	\
+})
+
+#define cmpxchg_double(p1, p2, o1, o2, n1, n2)				\
+({									\
+	int __ret;							\
+	smp_mb();							\
+	__ret = cmpxchg_double_local(p1, p2, o1, o2, n1, n2);		\
+	smp_mb();							\
+	__ret;								\
+})
+#endif
+
 #else 
 
 #define cmpxchg64_local(ptr, o, n) __cmpxchg64_local_generic((ptr), (o), (n))
@@ -0,0 +1,34 @@
+/*
+ * linux/arch/arm/include/asm/neon.h
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#ifndef __ASM_ARM_NEON_H
+#define __ASM_ARM_NEON_H
+
+#include <asm/hwcap.h>
+
+#define cpu_has_neon()		(!!(elf_hwcap & HWCAP_NEON))
+
+#ifdef __ARM_NEON__
+/*
+ * Units built with -mfpu=neon may get NEON instructions from the compiler
+ * anywhere, so they must not open a kernel NEON section themselves. Keep
+ * the NEON code in its own unit and bracket the calls from another one.
+ */
+#define kernel_neon_begin()	BUILD_BUG()
+#else
+/*
+ * kernel_neon_begin/end bracket a preempt-disabled section in which the
+ * kernel may use the NEON registers. The user VFP state of the current
+ * task is saved first and reloaded lazily on its next VFP instruction.
+ * Must not be used from interrupt context.
+ */
+void kernel_neon_begin(void);
+#endif
+void kernel_neon_end(void);
+
+#endif
@@ -0,0 +1,32 @@
+/*
+ * arch/arm/include/asm/percpu.h
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+#ifndef _ASM_ARM_PERCPU_H_
+#define _ASM_ARM_PERCPU_H_
+
+#include <asm/cmpxchg.h>
+
+#ifdef CONFIG_HAVE_CMPXCHG_DOUBLE
+/*
+ * An exclusive pair access is atomic against interrupts, so only
+ * migration has to be kept out while the per-cpu address is in use.
+ */
+#define this_cpu_cmpxchg_double_4(pcp1, pcp2, oval1, oval2, nval1, nval2) \
+({									\
+	int __ret;							\
+	preempt_disable();						\
+	__ret = cmpxchg_double_local(__this_cpu_ptr(&(pcp1)),		\
+				     __this_cpu_ptr(&(pcp2)),		\
+				     oval1, oval2, nval1, nval2);	\
+	preempt_enable();						\
+	__ret;								\
+})
+#endif
+
+#include <asm-generic/percpu.h>
+
+#endif /* _ASM_ARM_PERCPU_H_ */
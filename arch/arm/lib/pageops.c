@@ -0,0 +1,121 @@
+/*
+ *  linux/arch/arm/lib/pageops.c
+ *
+ *  copy_page()/clear_page() dispatch between the integer and NEON
+ *  implementations, chosen by a boot-time benchmark.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+#include <linux/export.h>
+#include <linux/gfp.h>
+#include <linux/hardirq.h>
+#include <linux/init.h>
+#include <linux/kernel.h>
+#include <linux/ktime.h>
+#include <linux/math64.h>
+#include <linux/mm.h>
+#include <linux/string.h>
+
+#include <asm/neon.h>
+#include <asm/page.h>
+
+extern void copy_page_arm(void *to, const void *from);
+extern void copy_page_neon(void *to, const void *from);
+extern void clear_page_neon(void *page);
+
+static bool neon_copy_page __read_mostly;
+static bool neon_clear_page __read_mostly;
+
+void copy_page(void *to, const void *from)
+{
+	if (neon_copy_page && !in_interrupt()) {
+		kernel_neon_begin();
+		copy_page_neon(to, from);
+		kernel_neon_end();
+	} else {
+		copy_page_arm(to, from);
+	}
+}
+
+void clear_page(void *page)
+{
+	if (neon_clear_page && !in_interrupt()) {
+		kernel_neon_begin();
+		clear_page_neon(page);
+		kernel_neon_end();
+	} else {
+		memset(page, 0, PAGE_SIZE);
+	}
+}
+EXPORT_SYMBOL(clear_page);
+
+#define PAGEOPS_BENCH_LOOPS	256
+
+/* nanoseconds for PAGEOPS_BENCH_LOOPS copies (from != NULL) or clears */
+static s64 __init pageops_time(void *to, void *from, bool neon)
+{
+	ktime_t start;
+	int i;
+
+	preempt_disable();
+	start = ktime_get();
+	for (i = 0; i < PAGEOPS_BENCH_LOOPS; i++) {
+		if (neon)
+			kernel_neon_begin();
+		if (from && neon)
+			copy_page_neon(to, from);
+		else if (from)
+			copy_page_arm(to, from);
+		else if (neon)
+			clear_page_neon(to);
+		else
+			memset(to, 0, PAGE_SIZE);
+		if (neon)
+			kernel_neon_end();
+	}
+	preempt_enable();
+	return ktime_to_ns(ktime_sub(ktime_get(), start));
+}
+
+static unsigned int __init pageops_speed(s64 ns)
+{
+	return div64_u64((u64)PAGEOPS_BENCH_LOOPS * PAGE_SIZE * 1000,
+			 max_t(s64, ns, 1));
+}
+
+static bool __init pageops_choose(const char *name, void *to, void *from)
+{
+	s64 arm_ns, neon_ns;
+
+	/* warm up caches and TLB for both buffers first */
+	pageops_time(to, from, false);
+	arm_ns = pageops_time(to, from, false);
+	neon_ns = pageops_time(to, from, true);
+
+	pr_info("%s: arm %u MB/s, neon %u MB/s, using %s\n", name,
+		pageops_speed(arm_ns), pageops_speed(neon_ns),
+		neon_ns < arm_ns ? "neon" : "arm");
+	return neon_ns < arm_ns;
+}
+
+static int __init pageops_calibrate(void)
+{
+	unsigned long pages;
+
+	if (!cpu_has_neon())
+		return 0;
+
+	pages = __get_free_pages(GFP_KERNEL, 1);
+	if (!pages)
+		return -ENOMEM;
+
+	neon_copy_page = pageops_choose("copy_page", (void *)pages,
+					(void *)(pages + PAGE_SIZE));
+	neon_clear_page = pageops_choose("clear_page", (void *)pages, NULL);
+
+	free_pages(pages, 1);
+	return 0;
+}
+late_initcall(pageops_calibrate);
@@ -0,0 +1,122 @@
+/*
+ * linux/arch/arm/lib/xor-neon.c
+ *
+ * NEON xor routines, only to be called between kernel_neon_begin() and
+ * kernel_neon_end(); see asm/xor.h.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#include <linux/module.h>
+#include <linux/raid/xor.h>
+
+MODULE_LICENSE("GPL");
+
+#ifndef __ARM_NEON__
+#error You should compile this file with '-mfloat-abi=softfp -mfpu=neon'
+#endif
+
+/* 64 bytes per iteration: p1 in q0-q3, each source in q8-q11 */
+#define XOR_LOAD_P1							\
+	"1:	vld1.64	{d0-d3}, [%[p1]]!\n\t"				\
+	"	vld1.64	{d4-d7}, [%[p1]]!\n\t"
+#define XOR_SRC(p)							\
+	"	vld1.64	{d16-d19}, [%[" p "]]!\n\t"			\
+	"	vld1.64	{d20-d23}, [%[" p "]]!\n\t"			\
+	"	veor	q0, q0, q8\n\t"					\
+	"	veor	q1, q1, q9\n\t"					\
+	"	veor	q2, q2, q10\n\t"				\
+	"	veor	q3, q3, q11\n\t"
+#define XOR_STORE							\
+	"	vst1.64	{d0-d3}, [%[dst]]!\n\t"				\
+	"	vst1.64	{d4-d7}, [%[dst]]!\n\t"				\
+	"	subs	%[lines], %[lines], #1\n\t"			\
+	"	bne	1b\n\t"
+#define XOR_CLOBBERS							\
+	"cc", "memory", "d0", "d1", "d2", "d3", "d4", "d5", "d6", "d7",	\
+	"d16", "d17", "d18", "d19", "d20", "d21", "d22", "d23"
+
+static void
+xor_neon_2(unsigned long bytes, unsigned long *p1, unsigned long *p2)
+{
+	unsigned long lines = bytes / 64;
+	unsigned long *dst = p1;
+
+	asm volatile(
+		XOR_LOAD_P1
+		XOR_SRC("p2")
+		XOR_STORE
+		: [dst] "+r" (dst), [p1] "+r" (p1), [p2] "+r" (p2),
+		  [lines] "+r" (lines)
+		:
+		: XOR_CLOBBERS);
+}
+
+static void
+xor_neon_3(unsigned long bytes, unsigned long *p1, unsigned long *p2,
+	   unsigned long *p3)
+{
+	unsigned long lines = bytes / 64;
+	unsigned long *dst = p1;
+
+	asm volatile(
+		XOR_LOAD_P1
+		XOR_SRC("p2")
+		XOR_SRC("p3")
+		XOR_STORE
+		: [dst] "+r" (dst), [p1] "+r" (p1), [p2] "+r" (p2),
+		  [p3] "+r" (p3), [lines] "+r" (lines)
+		:
+		: XOR_CLOBBERS);
+}
+
+static void
+xor_neon_4(unsigned long bytes, unsigned long *p1, unsigned long *p2,
+	   unsigned long *p3, unsigned long *p4)
+{
+	unsigned long lines = bytes / 64;
+	unsigned long *dst = p1;
+
+	asm volatile(
+		XOR_LOAD_P1
+		XOR_SRC("p2")
+		XOR_SRC("p3")
+		XOR_SRC("p4")
+		XOR_STORE
+		: [dst] "+r" (dst), [p1] "+r" (p1), [p2] "+r" (p2),
+		  [p3] "+r" (p3), [p4] "+r" (p4), [lines] "+r" (lines)
+		:
+		: XOR_CLOBBERS);
+}
+
+static void
+xor_neon_5(unsigned long bytes, unsigned long *p1, unsigned long *p2,
+	   unsigned long *p3, unsigned long *p4, unsigned long *p5)
+{
+	unsigned long lines = bytes / 64;
+	unsigned long *dst = p1;
+
+	asm volatile(
+		XOR_LOAD_P1
+		XOR_SRC("p2")
+		XOR_SRC("p3")
+		XOR_SRC("p4")
+		XOR_SRC("p5")
+		XOR_STORE
+		: [dst] "+r" (dst), [p1] "+r" (p1), [p2] "+r" (p2),
+		  [p3] "+r" (p3), [p4] "+r" (p4), [p5] "+r" (p5),
+		  [lines] "+r" (lines)
+		:
+		: XOR_CLOBBERS);
+}
+
+struct xor_block_template const xor_block_neon_inner = {
+	.name	= "__inner_neon__",
+	.do_2	= xor_neon_2,
+	.do_3	= xor_neon_3,
+	.do_4	= xor_neon_4,
+	.do_5	= xor_neon_5,
+};
+EXPORT_SYMBOL(xor_block_neon_inner);
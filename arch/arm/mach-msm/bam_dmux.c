@@ -1650,7 +1650,8 @@ static void ul_timeout(struct work_struct *work)
 	}
 	ret = write_trylock_irqsave(&ul_wakeup_lock, flags);
 	if (!ret) { 
-		schedule_delayed_work(&ul_timeout_work,
+		queue_delayed_work(system_power_efficient_wq,
+				&ul_timeout_work,
 				msecs_to_jiffies(UL_TIMEOUT_DELAY));
 		return;
 	}
@@ -1675,7 +1676,8 @@ static void ul_timeout(struct work_struct *work)
 				__func__, ul_packet_written);
 			DBG("%s: pkt written %d\n", __func__, ul_packet_written);
 			ul_packet_written = 0;
-			schedule_delayed_work(&ul_timeout_work,
+			queue_delayed_work(system_power_efficient_wq,
+					&ul_timeout_work,
 					msecs_to_jiffies(UL_TIMEOUT_DELAY));
 		} else {
 			ul_powerdown();
@@ -1741,7 +1743,8 @@ static void ul_wakeup(void)
 		}
 		if (likely(do_vote_dfab))
 			vote_dfab();
-		schedule_delayed_work(&ul_timeout_work,
+		queue_delayed_work(system_power_efficient_wq,
+				&ul_timeout_work,
 				msecs_to_jiffies(UL_TIMEOUT_DELAY));
 		bam_is_connected = 1;
 		mutex_unlock(&wakeup_lock);
@@ -1779,7 +1782,8 @@ static void ul_wakeup(void)
 	bam_is_connected = 1;
 	bam_dmux_log("%s complete\n", __func__);
 	pr_info(MODULE_NAME "%s complete\n", __func__);
-	schedule_delayed_work(&ul_timeout_work,
+	queue_delayed_work(system_power_efficient_wq,
+			&ul_timeout_work,
 				msecs_to_jiffies(UL_TIMEOUT_DELAY));
 	mutex_unlock(&wakeup_lock);
 }
@@ -3816,6 +3816,9 @@ static struct msm_thermal_data msm_thermal_pdata = {
 	.limit_temp = LIMIT_TEMP_MAX,
 	.temp_hysteresis = 10,
 	.limit_freq = 918000,
+	.core_sensor_count = 4,
+	.core_sensor_id = { 7, 8, 9, 10 },
+	.core_offline_temp = 10,
 };
 
 #define MSM_SHARED_RAM_PHYS 0x80000000
@@ -12,6 +12,8 @@
 #include <linux/mm.h>
 #include <linux/smp.h>
 #include <linux/percpu.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
 
 #include <asm/mmu_context.h>
 #include <asm/thread_notify.h>
@@ -19,11 +21,28 @@
 
 #include <mach/msm_rtb.h>
 
+/*
+ * mm->context.id holds the ASID generation above ASID_BITS and the
+ * hardware ASID below. ASIDs are handed out from a bitmap; when it runs
+ * out the generation is bumped and the bitmap is refilled with only the
+ * ASIDs that are live on some CPU, so running tasks keep theirs. Instead
+ * of interrupting the other CPUs, each one flushes its local TLB on its
+ * next context switch. ASID 0 is never allocated: it is the reserved
+ * context ID used while switching page tables.
+ */
+#define NUM_USER_ASIDS		(1 << ASID_BITS)
+
 static DEFINE_RAW_SPINLOCK(cpu_asid_lock);
-unsigned int cpu_last_asid = ASID_FIRST_VERSION;
-#ifdef CONFIG_SMP
-DEFINE_PER_CPU(struct mm_struct *, current_mm);
-#endif
+static unsigned int cpu_asid_generation = ASID_FIRST_VERSION;
+static DECLARE_BITMAP(asid_map, NUM_USER_ASIDS);
+
+static DEFINE_PER_CPU(atomic_t, active_asids);
+static DEFINE_PER_CPU(unsigned int, reserved_asids);
+static cpumask_t tlb_flush_pending;
+
+static unsigned long asid_allocs;
+static unsigned long asid_rollovers;
+static unsigned long asid_tlb_flushes;
 
 #ifdef CONFIG_ARM_LPAE
 #define cpu_set_asid(asid) {						\
@@ -109,88 +128,131 @@ void __init_new_context(struct task_struct *tsk, struct mm_struct *mm)
 	raw_spin_lock_init(&mm->context.id_lock);
 }
 
-static void flush_context(void)
+static void flush_context(unsigned int cpu)
 {
-	
-	set_asid(0);
-	local_flush_tlb_all();
-	if (icache_is_vivt_asid_tagged()) {
-		__flush_icache_all();
-		dsb();
+	unsigned int asid;
+	int i;
+
+	bitmap_zero(asid_map, NUM_USER_ASIDS);
+	for_each_possible_cpu(i) {
+		if (i == cpu) {
+			asid = 0;
+		} else {
+			asid = atomic_xchg(&per_cpu(active_asids, i), 0);
+			/*
+			 * A CPU that has been through a rollover without
+			 * switching since still runs its reserved ASID, the
+			 * only trace left of that mm: keep it reserved.
+			 */
+			if (asid == 0)
+				asid = per_cpu(reserved_asids, i);
+			__set_bit(asid & ~ASID_MASK, asid_map);
+		}
+		per_cpu(reserved_asids, i) = asid;
 	}
+
+	cpumask_setall(&tlb_flush_pending);
+	asid_rollovers++;
 }
 
-#ifdef CONFIG_SMP
+static int is_reserved_asid(unsigned int asid)
+{
+	int cpu;
+
+	for_each_possible_cpu(cpu)
+		if (per_cpu(reserved_asids, cpu) == asid)
+			return 1;
+	return 0;
+}
 
-static void set_mm_context(struct mm_struct *mm, unsigned int asid)
+static unsigned int new_context(struct mm_struct *mm, unsigned int cpu)
 {
-	unsigned long flags;
+	unsigned int asid = mm->context.id;
+	unsigned int generation = cpu_asid_generation;
 
-	raw_spin_lock_irqsave(&mm->context.id_lock, flags);
-	if (likely((mm->context.id ^ cpu_last_asid) >> ASID_BITS)) {
-		mm->context.id = asid;
-		cpumask_clear(mm_cpumask(mm));
+	if (asid != 0 && is_reserved_asid(asid))
+		return generation | (asid & ~ASID_MASK);
+
+	asid = find_next_zero_bit(asid_map, NUM_USER_ASIDS, 1);
+	if (asid == NUM_USER_ASIDS) {
+		generation += ASID_FIRST_VERSION;
+		if (generation == 0)
+			generation = ASID_FIRST_VERSION;
+		cpu_asid_generation = generation;
+		flush_context(cpu);
+		asid = find_next_zero_bit(asid_map, NUM_USER_ASIDS, 1);
 	}
-	raw_spin_unlock_irqrestore(&mm->context.id_lock, flags);
+	__set_bit(asid, asid_map);
+	asid_allocs++;
+	cpumask_clear(mm_cpumask(mm));
 
-	cpumask_set_cpu(smp_processor_id(), mm_cpumask(mm));
+	return generation | asid;
 }
 
-static void reset_context(void *info)
+void check_and_switch_context(struct mm_struct *mm)
 {
-	unsigned int asid;
 	unsigned int cpu = smp_processor_id();
-	struct mm_struct *mm = per_cpu(current_mm, cpu);
+	unsigned long flags;
+	unsigned int asid;
 
-	if (!mm)
-		return;
+	if (unlikely(mm->context.kvm_seq != init_mm.context.kvm_seq))
+		__check_kvm_seq(mm);
 
-	smp_rmb();
-	asid = cpu_last_asid + cpu + 1;
+	asid = mm->context.id;
+	if (!((asid ^ ACCESS_ONCE(cpu_asid_generation)) >> ASID_BITS) &&
+	    atomic_xchg(&per_cpu(active_asids, cpu), asid))
+		goto switch_mm_fastpath;
 
-	flush_context();
-	set_mm_context(mm, asid);
+	raw_spin_lock_irqsave(&cpu_asid_lock, flags);
+	asid = mm->context.id;
+	if ((asid ^ cpu_asid_generation) >> ASID_BITS) {
+		asid = new_context(mm, cpu);
+		mm->context.id = asid;
+	}
 
-	
-	set_asid(mm->context.id);
-}
+	if (cpumask_test_and_clear_cpu(cpu, &tlb_flush_pending)) {
+		set_asid(0);
+		local_flush_tlb_all();
+		if (icache_is_vivt_asid_tagged()) {
+			__flush_icache_all();
+			dsb();
+		}
+		asid_tlb_flushes++;
+	}
 
-#else
+	atomic_set(&per_cpu(active_asids, cpu), asid);
+	cpumask_set_cpu(cpu, mm_cpumask(mm));
+	raw_spin_unlock_irqrestore(&cpu_asid_lock, flags);
 
-static inline void set_mm_context(struct mm_struct *mm, unsigned int asid)
-{
-	mm->context.id = asid;
-	cpumask_copy(mm_cpumask(mm), cpumask_of(smp_processor_id()));
+switch_mm_fastpath:
+	cpu_switch_mm(mm->pgd, mm);
 }
 
-#endif
+static int asid_stats_show(struct seq_file *m, void *unused)
+{
+	seq_printf(m, "generation:  %u\n", cpu_asid_generation >> ASID_BITS);
+	seq_printf(m, "allocations: %lu\n", asid_allocs);
+	seq_printf(m, "rollovers:   %lu\n", asid_rollovers);
+	seq_printf(m, "tlb_flushes: %lu\n", asid_tlb_flushes);
+	return 0;
+}
 
-void __new_context(struct mm_struct *mm)
+static int asid_stats_open(struct inode *inode, struct file *file)
 {
-	unsigned int asid;
+	return single_open(file, asid_stats_show, NULL);
+}
 
-	raw_spin_lock(&cpu_asid_lock);
-#ifdef CONFIG_SMP
-	if (unlikely(((mm->context.id ^ cpu_last_asid) >> ASID_BITS) == 0)) {
-		cpumask_set_cpu(smp_processor_id(), mm_cpumask(mm));
-		raw_spin_unlock(&cpu_asid_lock);
-		return;
-	}
-#endif
-	asid = ++cpu_last_asid;
-	if (asid == 0)
-		asid = cpu_last_asid = ASID_FIRST_VERSION;
-
-	if (unlikely((asid & ~ASID_MASK) == 0)) {
-		asid = cpu_last_asid + smp_processor_id() + 1;
-		flush_context();
-#ifdef CONFIG_SMP
-		smp_wmb();
-		smp_call_function(reset_context, NULL, 1);
-#endif
-		cpu_last_asid += NR_CPUS;
-	}
+static const struct file_operations asid_stats_fops = {
+	.open		= asid_stats_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
 
-	set_mm_context(mm, asid);
-	raw_spin_unlock(&cpu_asid_lock);
+static int __init asid_stats_init(void)
+{
+	debugfs_create_file("asid_stats", S_IRUGO, NULL, NULL,
+			    &asid_stats_fops);
+	return 0;
 }
+late_initcall(asid_stats_init);
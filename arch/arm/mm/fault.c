@@ -259,7 +259,7 @@ void do_bad_area(unsigned long addr, unsigned int fsr, struct pt_regs *regs)
 #define VM_FAULT_BADMAP		0x010000
 #define VM_FAULT_BADACCESS	0x020000
 
-static inline bool access_error(unsigned int fsr, struct vm_area_struct *vma)
+static inline unsigned int access_mask(unsigned int fsr)
 {
 	unsigned int mask = VM_READ | VM_WRITE | VM_EXEC;
 
@@ -268,7 +268,12 @@ static inline bool access_error(unsigned int fsr, struct vm_area_struct *vma)
 	if (fsr & FSR_LNX_PF)
 		mask = VM_EXEC;
 
-	return vma->vm_flags & mask ? false : true;
+	return mask;
+}
+
+static inline bool access_error(unsigned int fsr, struct vm_area_struct *vma)
+{
+	return vma->vm_flags & access_mask(fsr) ? false : true;
 }
 
 static int __kprobes
@@ -325,11 +330,19 @@ do_page_fault(unsigned long addr, unsigned int fsr, struct pt_regs *regs)
 	if (in_atomic() || !mm)
 		goto no_context;
 
+	fault = handle_speculative_fault(mm, addr, flags, access_mask(fsr));
+	if (!(fault & VM_FAULT_RETRY)) {
+		perf_sw_event(PERF_COUNT_SW_PAGE_FAULTS, 1, regs, addr);
+		tsk->min_flt++;
+		perf_sw_event(PERF_COUNT_SW_PAGE_FAULTS_MIN, 1, regs, addr);
+		return 0;
+	}
+
 	if (!down_read_trylock(&mm->mmap_sem)) {
 		if (!user_mode(regs) && !search_exception_tables(regs->ARM_pc))
 			goto no_context;
 retry:
-		down_read(&mm->mmap_sem);
+		fault_down_read_mmap_sem(mm);
 	} else {
 		might_sleep();
 #ifdef CONFIG_DEBUG_VM
@@ -13,11 +13,98 @@
 #include <linux/module.h>
 #include <linux/highmem.h>
 #include <linux/interrupt.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
 #include <asm/fixmap.h>
 #include <asm/cacheflush.h>
 #include <asm/tlbflush.h>
 #include "mm.h"
 
+/*
+ * Besides the KM_TYPE_NR stack slots, each CPU owns KMAP_CACHE_NR fixmap
+ * slots indexed by pfn whose mappings are left in place after
+ * kunmap_atomic(). Mapping the same page again on that CPU, as zram and
+ * the page cache copy routines tend to do, then skips the PTE write and
+ * the TLB flush. Not used with VIVT or aliasing caches, where a stale
+ * kernel alias would have to be flushed.
+ *
+ * The cache only uses fixmap slots the stack slots leave free: up to 16
+ * per CPU, rounded down to a power of two, and none at all once NR_CPUS
+ * is large enough for the stack slots to fill the fixmap area.
+ */
+#define KMAP_CACHE_BEGIN	(FIX_KMAP_BEGIN + KM_TYPE_NR * NR_CPUS)
+#define KMAP_CACHE_FREE		(KMAP_CACHE_BEGIN < FIX_KMAP_END ?	\
+				 (FIX_KMAP_END - KMAP_CACHE_BEGIN) / NR_CPUS : 0)
+#define KMAP_CACHE_NR		(KMAP_CACHE_FREE >= 16 ? 16 :	\
+				 KMAP_CACHE_FREE >= 8 ? 8 :	\
+				 KMAP_CACHE_FREE >= 4 ? 4 :	\
+				 KMAP_CACHE_FREE >= 2 ? 2 :	\
+				 KMAP_CACHE_FREE)
+
+struct kmap_cache {
+	unsigned long pfn[KMAP_CACHE_NR];
+	unsigned char busy[KMAP_CACHE_NR];
+	unsigned long maps;
+	unsigned long hits;
+};
+
+static DEFINE_PER_CPU(struct kmap_cache, kmap_cache);
+
+static inline bool kmap_cache_enabled(void)
+{
+#ifdef CONFIG_DEBUG_HIGHMEM
+	return false;
+#else
+	return KMAP_CACHE_NR && !cache_is_vivt() && !cache_is_vipt_aliasing();
+#endif
+}
+
+static void *kmap_cache_get(struct page *page)
+{
+	struct kmap_cache *kc = &__get_cpu_var(kmap_cache);
+	unsigned long pfn = page_to_pfn(page);
+	unsigned int slot = pfn & (KMAP_CACHE_NR - 1);
+	unsigned long vaddr;
+	unsigned long flags;
+
+	vaddr = __fix_to_virt(KMAP_CACHE_BEGIN +
+			      KMAP_CACHE_NR * smp_processor_id() + slot);
+
+	local_irq_save(flags);
+	kc->maps++;
+	if (kc->pfn[slot] == pfn) {
+		kc->hits++;
+	} else if (!kc->busy[slot]) {
+		kc->pfn[slot] = pfn;
+		set_top_pte(vaddr, mk_pte(page, kmap_prot));
+	} else {
+		vaddr = 0;
+	}
+	if (vaddr)
+		kc->busy[slot]++;
+	local_irq_restore(flags);
+
+	return (void *)vaddr;
+}
+
+static void kmap_cache_put(unsigned long vaddr)
+{
+	unsigned int slot = (__virt_to_fix(vaddr) - KMAP_CACHE_BEGIN) &
+			    (KMAP_CACHE_NR - 1);
+
+	__get_cpu_var(kmap_cache).busy[slot]--;
+}
+
+static void kmap_set_top_pte(unsigned long vaddr, pte_t pte)
+{
+	if (kmap_cache_enabled() &&
+	    pte_val(get_top_pte(vaddr)) == pte_val(pte)) {
+		__this_cpu_inc(kmap_cache.hits);
+		return;
+	}
+	set_top_pte(vaddr, pte);
+}
+
 void *kmap(struct page *page)
 {
 	might_sleep();
@@ -56,6 +143,12 @@ void *kmap_atomic(struct page *page)
 	if (kmap)
 		return kmap;
 
+	if (kmap_cache_enabled()) {
+		kmap = kmap_cache_get(page);
+		if (kmap)
+			return kmap;
+	}
+
 	type = kmap_atomic_idx_push();
 
 	idx = type + KM_TYPE_NR * smp_processor_id();
@@ -63,7 +156,7 @@ void *kmap_atomic(struct page *page)
 #ifdef CONFIG_DEBUG_HIGHMEM
 	BUG_ON(!pte_none(get_top_pte(vaddr)));
 #endif
-	set_top_pte(vaddr, mk_pte(page, kmap_prot));
+	kmap_set_top_pte(vaddr, mk_pte(page, kmap_prot));
 
 	return (void *)vaddr;
 }
@@ -74,7 +167,9 @@ void __kunmap_atomic(void *kvaddr)
 	unsigned long vaddr = (unsigned long) kvaddr & PAGE_MASK;
 	int idx, type;
 
-	if (kvaddr >= (void *)FIXADDR_START) {
+	if (KMAP_CACHE_NR && vaddr >= __fix_to_virt(KMAP_CACHE_BEGIN)) {
+		kmap_cache_put(vaddr);
+	} else if (kvaddr >= (void *)FIXADDR_START) {
 		type = kmap_atomic_idx();
 		idx = type + KM_TYPE_NR * smp_processor_id();
 
@@ -108,7 +203,7 @@ void *kmap_atomic_pfn(unsigned long pfn)
 #ifdef CONFIG_DEBUG_HIGHMEM
 	BUG_ON(!pte_none(get_top_pte(vaddr)));
 #endif
-	set_top_pte(vaddr, pfn_pte(pfn, kmap_prot));
+	kmap_set_top_pte(vaddr, pfn_pte(pfn, kmap_prot));
 
 	return (void *)vaddr;
 }
@@ -122,3 +217,40 @@ struct page *kmap_atomic_to_page(const void *ptr)
 
 	return pte_page(get_top_pte(vaddr));
 }
+
+static int kmap_cache_show(struct seq_file *m, void *unused)
+{
+	int cpu;
+
+	for_each_possible_cpu(cpu) {
+		struct kmap_cache *kc = &per_cpu(kmap_cache, cpu);
+
+		seq_printf(m, "cpu%d: maps %lu tlb_flushes_saved %lu\n",
+			   cpu, kc->maps, kc->hits);
+	}
+	return 0;
+}
+
+static int kmap_cache_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, kmap_cache_show, NULL);
+}
+
+static const struct file_operations kmap_cache_fops = {
+	.open		= kmap_cache_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static int __init kmap_cache_init(void)
+{
+	BUILD_BUG_ON(KMAP_CACHE_NR &&
+		     KMAP_CACHE_BEGIN + KMAP_CACHE_NR * NR_CPUS > FIX_KMAP_END);
+	BUILD_BUG_ON(KMAP_CACHE_NR & (KMAP_CACHE_NR - 1));
+
+	debugfs_create_file("kmap_cache", S_IRUGO, NULL, NULL,
+			    &kmap_cache_fops);
+	return 0;
+}
+late_initcall(kmap_cache_init);
@@ -548,6 +548,12 @@ static void __init free_highpages(void)
 		if (end <= max_low)
 			continue;
 
+		/* the deferred part is freed by the pgdatinit threads */
+		if (end > deferred_init_pfn())
+			end = deferred_init_pfn();
+		if (end <= max_low || start >= end)
+			continue;
+
 		
 		if (start < max_low)
 			start = max_low;
@@ -54,6 +54,9 @@ struct dpm_drv_wd_data {
 
 static int async_error;
 
+static LIST_HEAD(dpm_deferred_list);
+static DEFINE_MUTEX(dpm_deferred_mtx);
+
 void device_pm_init(struct device *dev)
 {
 	dev->power.is_prepared = false;
@@ -64,6 +67,7 @@ void device_pm_init(struct device *dev)
 	spin_lock_init(&dev->power.lock);
 	pm_runtime_init(dev);
 	INIT_LIST_HEAD(&dev->power.entry);
+	INIT_LIST_HEAD(&dev->power.deferred_entry);
 	dev->power.power_state = PMSG_INVALID;
 }
 
@@ -77,10 +81,49 @@ void device_pm_unlock(void)
 	mutex_unlock(&dpm_list_mtx);
 }
 
+/*
+ * Devices named in pm_async_devices= are known to be safe to suspend and
+ * resume asynchronously with respect to everything but their parent and
+ * children, so opt them in as they are registered.
+ */
+static char pm_async_devices[256];
+
+static int __init pm_async_devices_setup(char *str)
+{
+	strlcpy(pm_async_devices, str, sizeof(pm_async_devices));
+	return 1;
+}
+__setup("pm_async_devices=", pm_async_devices_setup);
+
+static bool dpm_async_listed(struct device *dev)
+{
+	const char *name = dev_name(dev);
+	const char *p = pm_async_devices;
+	size_t len;
+
+	if (!*p || !name)
+		return false;
+
+	len = strlen(name);
+	while (*p) {
+		const char *end = strchr(p, ',');
+		size_t n = end ? end - p : strlen(p);
+
+		if (n == len && !strncmp(p, name, len))
+			return true;
+		if (!end)
+			break;
+		p = end + 1;
+	}
+	return false;
+}
+
 void device_pm_add(struct device *dev)
 {
 	pr_debug("PM: Adding info for %s:%s\n",
 		 dev->bus ? dev->bus->name : "No Bus", dev_name(dev));
+	if (dpm_async_listed(dev))
+		device_enable_async_suspend(dev);
 	mutex_lock(&dpm_list_mtx);
 	if (dev->parent && dev->parent->power.is_prepared)
 		dev_warn(dev, "parent %s should not be sleeping\n",
@@ -99,6 +142,9 @@ void device_pm_remove(struct device *dev)
 	dev_pm_qos_constraints_destroy(dev);
 	list_del_init(&dev->power.entry);
 	mutex_unlock(&dpm_list_mtx);
+	mutex_lock(&dpm_deferred_mtx);
+	list_del_init(&dev->power.deferred_entry);
+	mutex_unlock(&dpm_deferred_mtx);
 	device_wakeup_disable(dev);
 	pm_runtime_remove(dev);
 }
@@ -372,13 +418,17 @@ static void dpm_resume_noirq(pm_message_t state)
 	mutex_lock(&dpm_list_mtx);
 	while (!list_empty(&dpm_noirq_list)) {
 		struct device *dev = to_device(dpm_noirq_list.next);
+		ktime_t calltime;
 		int error;
 
 		get_device(dev);
 		list_move_tail(&dev->power.entry, &dpm_late_early_list);
 		mutex_unlock(&dpm_list_mtx);
 
+		calltime = ktime_get();
 		error = device_resume_noirq(dev, state);
+		dpm_profile_device(dev, DPM_PROFILE_RESUME_NOIRQ, calltime,
+				   false);
 		if (error) {
 			suspend_stats.failed_resume_noirq++;
 			dpm_save_failed_step(SUSPEND_RESUME_NOIRQ);
@@ -391,6 +441,7 @@ static void dpm_resume_noirq(pm_message_t state)
 	}
 	mutex_unlock(&dpm_list_mtx);
 	dpm_show_time(starttime, state, "noirq");
+	dpm_profile_phase(DPM_PROFILE_RESUME_NOIRQ, starttime);
 	resume_device_irqs();
 }
 
@@ -435,13 +486,17 @@ static void dpm_resume_early(pm_message_t state)
 	mutex_lock(&dpm_list_mtx);
 	while (!list_empty(&dpm_late_early_list)) {
 		struct device *dev = to_device(dpm_late_early_list.next);
+		ktime_t calltime;
 		int error;
 
 		get_device(dev);
 		list_move_tail(&dev->power.entry, &dpm_suspended_list);
 		mutex_unlock(&dpm_list_mtx);
 
+		calltime = ktime_get();
 		error = device_resume_early(dev, state);
+		dpm_profile_device(dev, DPM_PROFILE_RESUME_EARLY, calltime,
+				   false);
 		if (error) {
 			suspend_stats.failed_resume_early++;
 			dpm_save_failed_step(SUSPEND_RESUME_EARLY);
@@ -454,6 +509,7 @@ static void dpm_resume_early(pm_message_t state)
 	}
 	mutex_unlock(&dpm_list_mtx);
 	dpm_show_time(starttime, state, "early");
+	dpm_profile_phase(DPM_PROFILE_RESUME_EARLY, starttime);
 }
 
 void dpm_resume_start(pm_message_t state)
@@ -463,24 +519,10 @@ void dpm_resume_start(pm_message_t state)
 }
 EXPORT_SYMBOL_GPL(dpm_resume_start);
 
-static int device_resume(struct device *dev, pm_message_t state, bool async)
+static int dpm_resume_callback(struct device *dev, pm_message_t state)
 {
 	pm_callback_t callback = NULL;
 	char *info = NULL;
-	int error = 0;
-
-	TRACE_DEVICE(dev);
-	TRACE_RESUME(0);
-
-	dpm_wait(dev->parent, async);
-	device_lock(dev);
-
-	dev->power.is_prepared = false;
-
-	if (!dev->power.is_suspended)
-		goto Unlock;
-
-	pm_runtime_enable(dev);
 
 	if (dev->pm_domain) {
 		info = "power domain ";
@@ -524,7 +566,71 @@ static int device_resume(struct device *dev, pm_message_t state, bool async)
 	}
 
  End:
-	error = dpm_run_callback(callback, dev, state, info);
+	return dpm_run_callback(callback, dev, state, info);
+}
+
+static int dpm_has_child(struct device *dev, void *unused)
+{
+	return 1;
+}
+
+/*
+ * Leave a resume-on-demand device suspended at the end of a plain system
+ * resume. Only leaf devices qualify, since children expect their parent
+ * to be resumed first. Runtime PM stays disabled until the device is
+ * actually resumed.
+ */
+static bool dpm_defer_resume(struct device *dev, pm_message_t state)
+{
+	if (!dev->power.resume_on_demand || !pm_resume_on_demand_enabled ||
+	    state.event != PM_EVENT_RESUME)
+		return false;
+
+	if (device_for_each_child(dev, NULL, dpm_has_child))
+		return false;
+
+	if (!dev->power.resume_pending) {
+		dev->power.resume_pending = true;
+		mutex_lock(&dpm_deferred_mtx);
+		list_add_tail(&dev->power.deferred_entry, &dpm_deferred_list);
+		mutex_unlock(&dpm_deferred_mtx);
+	}
+	suspend_stats.deferred_resume++;
+	return true;
+}
+
+static void dpm_clear_deferred(struct device *dev)
+{
+	dev->power.resume_pending = false;
+	mutex_lock(&dpm_deferred_mtx);
+	list_del_init(&dev->power.deferred_entry);
+	mutex_unlock(&dpm_deferred_mtx);
+}
+
+static int device_resume(struct device *dev, pm_message_t state, bool async)
+{
+	int error = 0;
+
+	TRACE_DEVICE(dev);
+	TRACE_RESUME(0);
+
+	dpm_wait(dev->parent, async);
+	device_lock(dev);
+
+	dev->power.is_prepared = false;
+
+	if (!dev->power.is_suspended)
+		goto Unlock;
+
+	if (dpm_defer_resume(dev, state))
+		goto Unlock;
+
+	if (dev->power.resume_pending)
+		dpm_clear_deferred(dev);
+
+	pm_runtime_enable(dev);
+
+	error = dpm_resume_callback(dev, state);
 	dev->power.is_suspended = false;
 
  Unlock:
@@ -536,12 +642,116 @@ static int device_resume(struct device *dev, pm_message_t state, bool async)
 	return error;
 }
 
+/* Called with the device lock held. */
+static int __device_resume_deferred(struct device *dev)
+{
+	int error;
+
+	if (!dev->power.resume_pending)
+		return 0;
+
+	/* a system sleep transition owns the device until it completes */
+	if (dev->power.is_prepared)
+		return -EAGAIN;
+
+	dpm_clear_deferred(dev);
+
+	if (dev->parent)
+		pm_runtime_get_sync(dev->parent);
+
+	pm_runtime_enable(dev);
+	error = dpm_resume_callback(dev, PMSG_RESUME);
+	dev->power.is_suspended = false;
+
+	if (dev->parent)
+		pm_runtime_put(dev->parent);
+
+	if (error)
+		pm_dev_err(dev, PMSG_RESUME, " deferred", error);
+	return error;
+}
+
+/**
+ * device_set_resume_on_demand - Allow a device's resume to be deferred.
+ * @dev: Leaf device whose driver calls device_resume_on_demand() before
+ *	 touching the hardware.
+ * @enable: Whether to defer its system resume callback.
+ *
+ * The deferred resume callback runs on first use, from
+ * dpm_resume_deferred_devices() (late resume), or never if the system
+ * suspends again first, in which case the suspend callback is skipped too.
+ * The prepare and complete callbacks are still invoked every cycle.
+ *
+ * Must be called with the device lock held, as it is from the driver's
+ * probe and remove callbacks.
+ */
+void device_set_resume_on_demand(struct device *dev, bool enable)
+{
+	dev->power.resume_on_demand = enable;
+	if (!enable)
+		__device_resume_deferred(dev);
+}
+EXPORT_SYMBOL_GPL(device_set_resume_on_demand);
+
+/**
+ * device_resume_on_demand - Run a deferred resume callback, if pending.
+ * @dev: Device to resume.
+ *
+ * Must not be called with the device lock held.
+ */
+int device_resume_on_demand(struct device *dev)
+{
+	int error;
+
+	if (!dev->power.resume_pending)
+		return 0;
+
+	device_lock(dev);
+	error = __device_resume_deferred(dev);
+	device_unlock(dev);
+	if (!error)
+		suspend_stats.deferred_resume_on_demand++;
+
+	return error;
+}
+EXPORT_SYMBOL_GPL(device_resume_on_demand);
+
+void dpm_resume_deferred_devices(void)
+{
+	mutex_lock(&dpm_deferred_mtx);
+	while (!list_empty(&dpm_deferred_list)) {
+		struct device *dev = list_first_entry(&dpm_deferred_list,
+					struct device, power.deferred_entry);
+		bool pending;
+		int error;
+
+		get_device(dev);
+		mutex_unlock(&dpm_deferred_mtx);
+
+		device_lock(dev);
+		pending = dev->power.resume_pending;
+		error = __device_resume_deferred(dev);
+		device_unlock(dev);
+
+		put_device(dev);
+		if (error == -EAGAIN)
+			return;
+		if (pending)
+			suspend_stats.deferred_resume_late++;
+		mutex_lock(&dpm_deferred_mtx);
+	}
+	mutex_unlock(&dpm_deferred_mtx);
+}
+EXPORT_SYMBOL_GPL(dpm_resume_deferred_devices);
+
 static void async_resume(void *data, async_cookie_t cookie)
 {
 	struct device *dev = (struct device *)data;
+	ktime_t calltime = ktime_get();
 	int error;
 
 	error = device_resume(dev, pm_transition, true);
+	dpm_profile_device(dev, DPM_PROFILE_RESUME, calltime, true);
 	if (error)
 		pm_dev_err(dev, pm_transition, " async", error);
 	put_device(dev);
@@ -591,11 +801,14 @@ void dpm_resume(pm_message_t state)
 		dev = to_device(dpm_suspended_list.next);
 		get_device(dev);
 		if (!is_async(dev)) {
+			ktime_t calltime = ktime_get();
 			int error;
 
 			mutex_unlock(&dpm_list_mtx);
 
 			error = device_resume(dev, state, false);
+			dpm_profile_device(dev, DPM_PROFILE_RESUME, calltime,
+					   false);
 			if (error) {
 				suspend_stats.failed_resume++;
 				dpm_save_failed_step(SUSPEND_RESUME);
@@ -612,6 +825,7 @@ void dpm_resume(pm_message_t state)
 	mutex_unlock(&dpm_list_mtx);
 	async_synchronize_full();
 	dpm_show_time(starttime, state, NULL);
+	dpm_profile_phase(DPM_PROFILE_RESUME, starttime);
 }
 
 static void device_complete(struct device *dev, pm_message_t state)
@@ -653,6 +867,7 @@ static void device_complete(struct device *dev, pm_message_t state)
 void dpm_complete(pm_message_t state)
 {
 	struct list_head list;
+	ktime_t starttime = ktime_get();
 
 	might_sleep();
 
@@ -660,19 +875,24 @@ void dpm_complete(pm_message_t state)
 	mutex_lock(&dpm_list_mtx);
 	while (!list_empty(&dpm_prepared_list)) {
 		struct device *dev = to_device(dpm_prepared_list.prev);
+		ktime_t calltime;
 
 		get_device(dev);
 		dev->power.is_prepared = false;
 		list_move(&dev->power.entry, &list);
 		mutex_unlock(&dpm_list_mtx);
 
+		calltime = ktime_get();
 		device_complete(dev, state);
+		dpm_profile_device(dev, DPM_PROFILE_COMPLETE, calltime, false);
 
 		mutex_lock(&dpm_list_mtx);
 		put_device(dev);
 	}
 	list_splice(&list, &dpm_list);
 	mutex_unlock(&dpm_list_mtx);
+	dpm_profile_phase(DPM_PROFILE_COMPLETE, starttime);
+	dpm_profile_end();
 }
 
 void dpm_resume_end(pm_message_t state)
@@ -734,11 +954,15 @@ static int dpm_suspend_noirq(pm_message_t state)
 	mutex_lock(&dpm_list_mtx);
 	while (!list_empty(&dpm_late_early_list)) {
 		struct device *dev = to_device(dpm_late_early_list.prev);
+		ktime_t calltime;
 
 		get_device(dev);
 		mutex_unlock(&dpm_list_mtx);
 
+		calltime = ktime_get();
 		error = device_suspend_noirq(dev, state);
+		dpm_profile_device(dev, DPM_PROFILE_SUSPEND_NOIRQ, calltime,
+				   false);
 
 		mutex_lock(&dpm_list_mtx);
 		if (error) {
@@ -754,6 +978,7 @@ static int dpm_suspend_noirq(pm_message_t state)
 		put_device(dev);
 	}
 	mutex_unlock(&dpm_list_mtx);
+	dpm_profile_phase(DPM_PROFILE_SUSPEND_NOIRQ, starttime);
 	if (error)
 		dpm_resume_noirq(resume_event(state));
 	else
@@ -796,11 +1021,15 @@ static int dpm_suspend_late(pm_message_t state)
 	mutex_lock(&dpm_list_mtx);
 	while (!list_empty(&dpm_suspended_list)) {
 		struct device *dev = to_device(dpm_suspended_list.prev);
+		ktime_t calltime;
 
 		get_device(dev);
 		mutex_unlock(&dpm_list_mtx);
 
+		calltime = ktime_get();
 		error = device_suspend_late(dev, state);
+		dpm_profile_device(dev, DPM_PROFILE_SUSPEND_LATE, calltime,
+				   false);
 
 		mutex_lock(&dpm_list_mtx);
 		if (error) {
@@ -816,6 +1045,7 @@ static int dpm_suspend_late(pm_message_t state)
 		put_device(dev);
 	}
 	mutex_unlock(&dpm_list_mtx);
+	dpm_profile_phase(DPM_PROFILE_SUSPEND_LATE, starttime);
 	if (error)
 		dpm_resume_early(resume_event(state));
 	else
@@ -863,6 +1093,7 @@ static int __device_suspend(struct device *dev, pm_message_t state, bool async)
 	int error = 0;
 	struct timer_list timer;
 	struct dpm_drv_wd_data data;
+	bool skipped = false;
 
 	dpm_wait_for_children(dev, async);
 
@@ -893,6 +1124,13 @@ static int __device_suspend(struct device *dev, pm_message_t state, bool async)
 
 	device_lock(dev);
 
+	/* resume was deferred and never requested: still suspended */
+	if (dev->power.resume_pending) {
+		suspend_stats.deferred_suspend_skipped++;
+		skipped = true;
+		goto End;
+	}
+
 	if (dev->pm_domain) {
 		info = "power domain ";
 		callback = pm_op(&dev->pm_domain->ops, state);
@@ -954,7 +1192,7 @@ Complete:
 
 	if (error)
 		async_error = error;
-	else if (dev->power.is_suspended)
+	else if (dev->power.is_suspended && !skipped)
 		__pm_runtime_disable(dev, false);
 
 	return error;
@@ -963,9 +1201,11 @@ Complete:
 static void async_suspend(void *data, async_cookie_t cookie)
 {
 	struct device *dev = (struct device *)data;
+	ktime_t calltime = ktime_get();
 	int error;
 
 	error = __device_suspend(dev, pm_transition, true);
+	dpm_profile_device(dev, DPM_PROFILE_SUSPEND, calltime, true);
 	if (error) {
 		dpm_save_failed_dev(dev_name(dev));
 		pm_dev_err(dev, pm_transition, " async", error);
@@ -976,6 +1216,9 @@ static void async_suspend(void *data, async_cookie_t cookie)
 
 static int device_suspend(struct device *dev)
 {
+	ktime_t calltime;
+	int error;
+
 	INIT_COMPLETION(dev->power.completion);
 
 	if (pm_async_enabled && dev->power.async_suspend) {
@@ -984,7 +1227,10 @@ static int device_suspend(struct device *dev)
 		return 0;
 	}
 
-	return __device_suspend(dev, pm_transition, false);
+	calltime = ktime_get();
+	error = __device_suspend(dev, pm_transition, false);
+	dpm_profile_device(dev, DPM_PROFILE_SUSPEND, calltime, false);
+	return error;
 }
 
 int dpm_suspend(pm_message_t state)
@@ -1020,6 +1266,7 @@ int dpm_suspend(pm_message_t state)
 	}
 	mutex_unlock(&dpm_list_mtx);
 	async_synchronize_full();
+	dpm_profile_phase(DPM_PROFILE_SUSPEND, starttime);
 	if (!error)
 		error = async_error;
 	if (error) {
@@ -1079,18 +1326,23 @@ static int device_prepare(struct device *dev, pm_message_t state)
 
 int dpm_prepare(pm_message_t state)
 {
+	ktime_t starttime = ktime_get();
 	int error = 0;
 
 	might_sleep();
 
+	dpm_profile_begin(state);
 	mutex_lock(&dpm_list_mtx);
 	while (!list_empty(&dpm_list)) {
 		struct device *dev = to_device(dpm_list.next);
+		ktime_t calltime;
 
 		get_device(dev);
 		mutex_unlock(&dpm_list_mtx);
 
+		calltime = ktime_get();
 		error = device_prepare(dev, state);
+		dpm_profile_device(dev, DPM_PROFILE_PREPARE, calltime, false);
 
 		mutex_lock(&dpm_list_mtx);
 		if (error) {
@@ -1111,6 +1363,7 @@ int dpm_prepare(pm_message_t state)
 		put_device(dev);
 	}
 	mutex_unlock(&dpm_list_mtx);
+	dpm_profile_phase(DPM_PROFILE_PREPARE, starttime);
 	return error;
 }
 
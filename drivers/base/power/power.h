@@ -15,6 +15,7 @@ static inline void pm_runtime_remove(struct device *dev) {}
 #ifdef CONFIG_PM_SLEEP
 
 extern int pm_async_enabled;
+extern int pm_resume_on_demand_enabled;
 
 extern struct list_head dpm_list;	
 
@@ -30,6 +31,35 @@ extern void device_pm_move_before(struct device *, struct device *);
 extern void device_pm_move_after(struct device *, struct device *);
 extern void device_pm_move_last(struct device *);
 
+enum dpm_profile_phase {
+	DPM_PROFILE_PREPARE,
+	DPM_PROFILE_SUSPEND,
+	DPM_PROFILE_SUSPEND_LATE,
+	DPM_PROFILE_SUSPEND_NOIRQ,
+	DPM_PROFILE_RESUME_NOIRQ,
+	DPM_PROFILE_RESUME_EARLY,
+	DPM_PROFILE_RESUME,
+	DPM_PROFILE_COMPLETE,
+	DPM_PROFILE_PHASES,
+};
+
+#ifdef CONFIG_PM_SLEEP_PROFILE
+extern void dpm_profile_begin(pm_message_t state);
+extern void dpm_profile_end(void);
+extern void dpm_profile_phase(enum dpm_profile_phase phase, ktime_t start);
+extern void dpm_profile_device(struct device *dev,
+			       enum dpm_profile_phase phase,
+			       ktime_t start, bool async);
+#else
+static inline void dpm_profile_begin(pm_message_t state) {}
+static inline void dpm_profile_end(void) {}
+static inline void dpm_profile_phase(enum dpm_profile_phase phase,
+				     ktime_t start) {}
+static inline void dpm_profile_device(struct device *dev,
+				      enum dpm_profile_phase phase,
+				      ktime_t start, bool async) {}
+#endif
+
 #else 
 
 static inline void device_pm_init(struct device *dev)
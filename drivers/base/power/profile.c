@@ -0,0 +1,236 @@
+/*
+ * drivers/base/power/profile.c - Suspend/resume latency profiler
+ *
+ * Records per-phase totals and the slowest device callbacks of the last
+ * DPM_PROFILE_CYCLES system sleep transitions and reports them through
+ * debugfs (suspend_profile/).
+ *
+ * This file is released under the GPLv2.
+ */
+
+#include <linux/device.h>
+#include <linux/export.h>
+#include <linux/slab.h>
+#include <linux/sort.h>
+#include <linux/suspend.h>
+#include <linux/seq_file.h>
+#include <linux/debugfs.h>
+
+#include "power.h"
+
+#define DPM_PROFILE_CYCLES	8
+#define DPM_PROFILE_DEVS	64
+#define DPM_PROFILE_NAME_LEN	32
+#define DPM_PROFILE_HIGHLIGHT	5
+
+struct dpm_profile_dev {
+	char name[DPM_PROFILE_NAME_LEN];
+	u8 phase;
+	bool async;
+	u32 usecs;
+};
+
+struct dpm_profile_cycle {
+	unsigned int seq;
+	int event;
+	u64 total_usecs[DPM_PROFILE_PHASES];
+	u32 nr_calls[DPM_PROFILE_PHASES];
+	unsigned int nr_devs;
+	struct dpm_profile_dev devs[DPM_PROFILE_DEVS];
+};
+
+static const char * const dpm_profile_phase_names[DPM_PROFILE_PHASES] = {
+	[DPM_PROFILE_PREPARE]		= "prepare",
+	[DPM_PROFILE_SUSPEND]		= "suspend",
+	[DPM_PROFILE_SUSPEND_LATE]	= "suspend_late",
+	[DPM_PROFILE_SUSPEND_NOIRQ]	= "suspend_noirq",
+	[DPM_PROFILE_RESUME_NOIRQ]	= "resume_noirq",
+	[DPM_PROFILE_RESUME_EARLY]	= "resume_early",
+	[DPM_PROFILE_RESUME]		= "resume",
+	[DPM_PROFILE_COMPLETE]		= "complete",
+};
+
+static struct dpm_profile_cycle dpm_profile_cycles[DPM_PROFILE_CYCLES];
+static unsigned int dpm_profile_seq;
+static bool dpm_profile_active;
+static DEFINE_SPINLOCK(dpm_profile_lock);
+
+/* callbacks faster than this are only counted, not recorded */
+static u32 dpm_profile_min_us = 100;
+
+static struct dpm_profile_cycle *dpm_profile_current(void)
+{
+	return &dpm_profile_cycles[dpm_profile_seq % DPM_PROFILE_CYCLES];
+}
+
+static u32 dpm_profile_usecs(ktime_t start)
+{
+	s64 usecs = ktime_us_delta(ktime_get(), start);
+
+	return usecs > 0 ? min_t(s64, usecs, UINT_MAX) : 0;
+}
+
+void dpm_profile_begin(pm_message_t state)
+{
+	struct dpm_profile_cycle *cycle;
+	unsigned long flags;
+
+	spin_lock_irqsave(&dpm_profile_lock, flags);
+	dpm_profile_seq++;
+	cycle = dpm_profile_current();
+	memset(cycle, 0, sizeof(*cycle));
+	cycle->seq = dpm_profile_seq;
+	cycle->event = state.event;
+	dpm_profile_active = true;
+	spin_unlock_irqrestore(&dpm_profile_lock, flags);
+}
+
+void dpm_profile_end(void)
+{
+	dpm_profile_active = false;
+}
+
+void dpm_profile_phase(enum dpm_profile_phase phase, ktime_t start)
+{
+	u32 usecs = dpm_profile_usecs(start);
+	unsigned long flags;
+
+	spin_lock_irqsave(&dpm_profile_lock, flags);
+	if (dpm_profile_active)
+		dpm_profile_current()->total_usecs[phase] += usecs;
+	spin_unlock_irqrestore(&dpm_profile_lock, flags);
+}
+
+/*
+ * Keep the DPM_PROFILE_DEVS slowest callbacks of the cycle: once the table
+ * is full a new entry replaces the fastest one recorded so far.
+ */
+void dpm_profile_device(struct device *dev, enum dpm_profile_phase phase,
+			ktime_t start, bool async)
+{
+	u32 usecs = dpm_profile_usecs(start);
+	struct dpm_profile_cycle *cycle;
+	struct dpm_profile_dev *entry;
+	unsigned long flags;
+	unsigned int i;
+
+	spin_lock_irqsave(&dpm_profile_lock, flags);
+	if (!dpm_profile_active)
+		goto out;
+
+	cycle = dpm_profile_current();
+	cycle->nr_calls[phase]++;
+	if (usecs < dpm_profile_min_us)
+		goto out;
+
+	if (cycle->nr_devs < DPM_PROFILE_DEVS) {
+		entry = &cycle->devs[cycle->nr_devs++];
+	} else {
+		entry = &cycle->devs[0];
+		for (i = 1; i < DPM_PROFILE_DEVS; i++)
+			if (cycle->devs[i].usecs < entry->usecs)
+				entry = &cycle->devs[i];
+		if (entry->usecs >= usecs)
+			goto out;
+	}
+
+	strlcpy(entry->name, dev_name(dev), sizeof(entry->name));
+	entry->phase = phase;
+	entry->async = async;
+	entry->usecs = usecs;
+ out:
+	spin_unlock_irqrestore(&dpm_profile_lock, flags);
+}
+
+static int dpm_profile_cmp(const void *a, const void *b)
+{
+	const struct dpm_profile_dev *da = a, *db = b;
+
+	if (da->usecs == db->usecs)
+		return 0;
+	return da->usecs < db->usecs ? 1 : -1;
+}
+
+static void dpm_profile_show_cycle(struct seq_file *m,
+				   struct dpm_profile_cycle *cycle)
+{
+	unsigned int i;
+
+	seq_printf(m, "cycle %u (event 0x%x)\n", cycle->seq, cycle->event);
+	for (i = 0; i < DPM_PROFILE_PHASES; i++) {
+		if (!cycle->nr_calls[i] && !cycle->total_usecs[i])
+			continue;
+		seq_printf(m, "  %-14s %8llu us  %4u devices\n",
+			   dpm_profile_phase_names[i],
+			   (unsigned long long)cycle->total_usecs[i],
+			   cycle->nr_calls[i]);
+	}
+
+	sort(cycle->devs, cycle->nr_devs, sizeof(cycle->devs[0]),
+	     dpm_profile_cmp, NULL);
+	for (i = 0; i < cycle->nr_devs; i++) {
+		struct dpm_profile_dev *entry = &cycle->devs[i];
+
+		seq_printf(m, "  %c %-14s %8u us  %s%s\n",
+			   i < DPM_PROFILE_HIGHLIGHT ? '*' : ' ',
+			   dpm_profile_phase_names[entry->phase],
+			   entry->usecs, entry->name,
+			   entry->async ? " (async)" : "");
+	}
+	seq_putc(m, '\n');
+}
+
+static int dpm_profile_show(struct seq_file *m, void *unused)
+{
+	struct dpm_profile_cycle *cycle;
+	unsigned long flags;
+	unsigned int seq, n;
+
+	cycle = kmalloc(sizeof(*cycle), GFP_KERNEL);
+	if (!cycle)
+		return -ENOMEM;
+
+	seq = ACCESS_ONCE(dpm_profile_seq);
+	for (n = 0; n < DPM_PROFILE_CYCLES && n < seq; n++) {
+		spin_lock_irqsave(&dpm_profile_lock, flags);
+		memcpy(cycle, &dpm_profile_cycles[(seq - n) % DPM_PROFILE_CYCLES],
+		       sizeof(*cycle));
+		spin_unlock_irqrestore(&dpm_profile_lock, flags);
+
+		if (cycle->seq != seq - n)
+			break;
+		dpm_profile_show_cycle(m, cycle);
+	}
+
+	kfree(cycle);
+	return 0;
+}
+
+static int dpm_profile_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, dpm_profile_show, NULL);
+}
+
+static const struct file_operations dpm_profile_fops = {
+	.owner = THIS_MODULE,
+	.open = dpm_profile_open,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
+static int __init dpm_profile_debugfs_init(void)
+{
+	struct dentry *dir;
+
+	dir = debugfs_create_dir("suspend_profile", NULL);
+	if (!dir)
+		return -ENOMEM;
+
+	debugfs_create_file("cycles", S_IRUGO, dir, NULL, &dpm_profile_fops);
+	debugfs_create_u32("min_us", S_IRUGO | S_IWUSR, dir,
+			   &dpm_profile_min_us);
+	return 0;
+}
+
+late_initcall(dpm_profile_debugfs_init);
@@ -35,14 +35,33 @@ static atomic_t system_contig_heap_allocated;
 static unsigned int system_heap_has_outer_cache;
 static unsigned int system_heap_contig_has_outer_cache;
 
+#define ION_SYSTEM_BULK_PAGES	64
+
+static void ion_system_heap_free_pages(struct sg_table *table, int nents)
+{
+	struct page *pages[ION_SYSTEM_BULK_PAGES];
+	struct scatterlist *sg;
+	int i, n = 0;
+
+	for_each_sg(table->sgl, sg, nents, i) {
+		pages[n++] = sg_page(sg);
+		if (n == ION_SYSTEM_BULK_PAGES) {
+			free_pages_bulk(pages, n);
+			n = 0;
+		}
+	}
+	free_pages_bulk(pages, n);
+}
+
 static int ion_system_heap_allocate(struct ion_heap *heap,
 				     struct ion_buffer *buffer,
 				     unsigned long size, unsigned long align,
 				     unsigned long flags)
 {
+	struct page *pages[ION_SYSTEM_BULK_PAGES];
 	struct sg_table *table;
 	struct scatterlist *sg;
-	int i, j;
+	int i, n = 0, got = 0, want;
 	int npages = PAGE_ALIGN(size) / PAGE_SIZE;
 
 	table = kmalloc(sizeof(struct sg_table), GFP_KERNEL);
@@ -52,18 +71,23 @@ static int ion_system_heap_allocate(struct ion_heap *heap,
 	if (i)
 		goto err0;
 	for_each_sg(table->sgl, sg, table->nents, i) {
-		struct page *page;
-		page = alloc_page(GFP_KERNEL|__GFP_ZERO);
-		if (!page)
-			goto err1;
-		sg_set_page(sg, page, PAGE_SIZE, 0);
+		if (n == got) {
+			want = min(npages - i, ION_SYSTEM_BULK_PAGES);
+			got = alloc_pages_bulk(GFP_KERNEL|__GFP_ZERO, want,
+					       pages);
+			if (got < want) {
+				free_pages_bulk(pages, got);
+				goto err1;
+			}
+			n = 0;
+		}
+		sg_set_page(sg, pages[n++], PAGE_SIZE, 0);
 	}
 	buffer->priv_virt = table;
 	atomic_add(size, &system_heap_allocated);
 	return 0;
 err1:
-	for_each_sg(table->sgl, sg, i, j)
-		__free_page(sg_page(sg));
+	ion_system_heap_free_pages(table, i);
 	sg_free_table(table);
 err0:
 	kfree(table);
@@ -72,12 +96,9 @@ err0:
 
 void ion_system_heap_free(struct ion_buffer *buffer)
 {
-	int i;
-	struct scatterlist *sg;
 	struct sg_table *table = buffer->priv_virt;
 
-	for_each_sg(table->sgl, sg, table->nents, i)
-		__free_page(sg_page(sg));
+	ion_system_heap_free_pages(table, table->nents);
 	if (buffer->sg_table)
 		sg_free_table(buffer->sg_table);
 	kfree(buffer->sg_table);
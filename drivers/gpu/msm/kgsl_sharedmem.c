@@ -352,9 +352,12 @@ static int kgsl_page_alloc_vmflags(struct kgsl_memdesc *memdesc)
 	return VM_RESERVED | VM_DONTEXPAND;
 }
 
+#define KGSL_BULK_FREE_PAGES	64
+
 static void kgsl_page_alloc_free(struct kgsl_memdesc *memdesc)
 {
-	int i = 0;
+	int i = 0, n = 0;
+	struct page *pages[KGSL_BULK_FREE_PAGES];
 	struct scatterlist *sg;
 	int sglen = memdesc->sglen;
 
@@ -368,8 +371,17 @@ static void kgsl_page_alloc_free(struct kgsl_memdesc *memdesc)
 		for_each_sg(memdesc->sg, sg, sglen, i){
 			if (sg->length == 0)
 				break;
-			__free_pages(sg_page(sg), get_order(sg->length));
+			if (sg->length != PAGE_SIZE) {
+				__free_pages(sg_page(sg), get_order(sg->length));
+				continue;
+			}
+			pages[n++] = sg_page(sg);
+			if (n == KGSL_BULK_FREE_PAGES) {
+				free_pages_bulk(pages, n);
+				n = 0;
+			}
 		}
+	free_pages_bulk(pages, n);
 }
 
 static int kgsl_contiguous_vmflags(struct kgsl_memdesc *memdesc)
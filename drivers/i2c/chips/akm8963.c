@@ -99,9 +99,13 @@ static int akm8963_i2c_rxdata(
 		.len = length,
 		.buf = rxData,
 	}, };
+	int err;
 #if AKM8963_DEBUG_DATA
 	unsigned char addr = rxData[0];
 #endif
+	err = device_resume_on_demand(&i2c->dev);
+	if (err)
+		return err;
 	if (i2c_transfer(i2c->adapter, msgs, 2) < 0) {
 		dev_err(&i2c->dev, "%s: transfer failed.", __func__);
 		return -EIO;
@@ -124,7 +128,11 @@ static int akm8963_i2c_txdata(
 		.len = length,
 		.buf = txData,
 	}, };
+	int err;
 
+	err = device_resume_on_demand(&i2c->dev);
+	if (err)
+		return err;
 	if (i2c_transfer(i2c->adapter, msg, 1) < 0) {
 		dev_err(&i2c->dev, "%s: transfer failed.", __func__);
 		return -EIO;
@@ -1393,6 +1401,9 @@ int akm8963_probe(struct i2c_client *client, const struct i2c_device_id *id)
 		goto exit6;
 	}
 
+	/* nothing to redo on resume until the sensor is used again */
+	device_set_resume_on_demand(&client->dev, true);
+
 	dev_dbg(&client->dev, "successfully probed.");
 	return 0;
 
@@ -1415,6 +1426,7 @@ static int akm8963_remove(struct i2c_client *client)
 {
 	struct akm8963_data *akm = i2c_get_clientdata(client);
 
+	device_set_resume_on_demand(&client->dev, false);
 	remove_sysfs_interfaces(akm);
 	if (misc_deregister(&akm8963_dev) < 0)
 		dev_dbg(&client->dev, "misc deregister failed.");
@@ -1456,7 +1468,7 @@ static void __exit akm8963_exit(void)
 	i2c_del_driver(&akm8963_driver);
 }
 
-module_init(akm8963_init);
+module_init_async(akm8963_init);
 module_exit(akm8963_exit);
 
 MODULE_DESCRIPTION("AKM8963 compass driver");
@@ -100,6 +100,10 @@ static int bma250_smbus_read_byte(struct i2c_client *client,
 	s32 dummy;
 	int retry = 0;
 
+	dummy = device_resume_on_demand(&client->dev);
+	if (dummy)
+		return dummy;
+
 	for (retry = 0; retry < I2C_RETRY_COUNT; retry++) {
 		dummy = i2c_smbus_read_byte_data(client, reg_addr);
 		if (dummy < 0) {
@@ -124,6 +128,10 @@ static int bma250_smbus_write_byte(struct i2c_client *client,
 	s32 dummy;
 	int retry = 0;
 
+	dummy = device_resume_on_demand(&client->dev);
+	if (dummy)
+		return dummy;
+
 	for (retry = 0; retry < I2C_RETRY_COUNT; retry++) {
 		dummy = i2c_smbus_write_byte_data(client, reg_addr, *data);
 		if (dummy < 0) {
@@ -147,6 +155,10 @@ static int bma250_smbus_read_byte_block(struct i2c_client *client,
 	s32 dummy;
 	int retry = 0;
 
+	dummy = device_resume_on_demand(&client->dev);
+	if (dummy)
+		return dummy;
+
 	for (retry = 0; retry < I2C_RETRY_COUNT; retry++) {
 		dummy = i2c_smbus_read_i2c_block_data(client, reg_addr, len, data);
 		if (dummy < 0) {
@@ -167,7 +179,7 @@ static int bma250_smbus_read_byte_block(struct i2c_client *client,
 static int bma250_set_mode(struct i2c_client *client, unsigned char Mode)
 {
 	int comres = 0;
-	unsigned char data1;
+	unsigned char data1 = 0;
 	struct bma250_data *bma250 = i2c_get_clientdata(client);
 
 #ifdef CONFIG_CIR_ALWAYS_READY
@@ -177,6 +189,11 @@ static int bma250_set_mode(struct i2c_client *client, unsigned char Mode)
 #endif
 	I("%s++: mode = %d, bma250->ref_count = %d\n", __func__, Mode, bma250->ref_count);
 
+	/* the deferred resume callback sets the mode too */
+	comres = device_resume_on_demand(&client->dev);
+	if (comres)
+		return comres;
+
 	mutex_lock(&bma250->mode_mutex);
 	if (BMA250_MODE_SUSPEND == Mode) {
 		if (bma250->ref_count > 0) {
@@ -1873,15 +1890,24 @@ static ssize_t bma250_enable_show(struct device *dev,
 
 }
 
-static void bma250_set_enable(struct device *dev, int enable)
+static int bma250_set_enable(struct device *dev, int enable)
 {
 	struct i2c_client *client = to_i2c_client(dev);
 	struct bma250_data *bma250 = i2c_get_clientdata(client);
 	int pre_enable = atomic_read(&bma250->enable);
 	int i = 0;
+	int err;
 
 	I("%s: enable = %d\n", __func__, enable);
 
+	/*
+	 * The deferred resume callback takes enable_mutex, so run it before
+	 * we do rather than from the register accesses made under it.
+	 */
+	err = device_resume_on_demand(&client->dev);
+	if (err)
+		return err;
+
 	mutex_lock(&bma250->enable_mutex);
 	if (enable) {
 
@@ -1921,6 +1947,7 @@ static void bma250_set_enable(struct device *dev, int enable)
 
 	mutex_unlock(&bma250->enable_mutex);
 
+	return 0;
 }
 
 static ssize_t bma250_enable_store(struct device *dev,
@@ -1936,8 +1963,11 @@ static ssize_t bma250_enable_store(struct device *dev,
 
 	I("%s: data = %lu\n", __func__, data);
 
-	if ((data == 0) || (data == 1))
-		bma250_set_enable(dev, data);
+	if ((data == 0) || (data == 1)) {
+		error = bma250_set_enable(dev, data);
+		if (error)
+			return error;
+	}
 
 	return count;
 }
@@ -3497,6 +3527,9 @@ static int bma250_probe(struct i2c_client *client,
 #endif
 	wake_lock_init(&(data->sig_wake_lock), WAKE_LOCK_SUSPEND, "sig_motion");
 
+	/* leave the sensor off across dark resumes until it is read again */
+	device_set_resume_on_demand(&client->dev, true);
+
 	I("%s: BMA250 BOSCH driver probe successful", __func__);
 
 	return 0;
@@ -3545,6 +3578,9 @@ static void bma250_early_suspend(struct early_suspend *h)
 
 	D("%s++\n", __func__);
 
+	if (device_resume_on_demand(&data->bma250_client->dev))
+		return;
+
 	mutex_lock(&data->enable_mutex);
 	if (atomic_read(&data->enable) == 1) {
 	    I("suspend mode\n");
@@ -3562,6 +3598,9 @@ static void bma250_late_resume(struct early_suspend *h)
 
 	D("%s++\n", __func__);
 
+	if (device_resume_on_demand(&data->bma250_client->dev))
+		return;
+
 	mutex_lock(&data->enable_mutex);
 	if (atomic_read(&data->enable) == 1) {
 		bma250_set_mode(data->bma250_client, BMA250_MODE_NORMAL);
@@ -3576,6 +3615,7 @@ static int __devexit bma250_remove(struct i2c_client *client)
 {
 	struct bma250_data *data = i2c_get_clientdata(client);
 
+	device_set_resume_on_demand(&client->dev, false);
 	bma250_set_enable(&client->dev, 0);
 #ifdef CONFIG_HAS_EARLYSUSPEND
 	unregister_early_suspend(&data->early_suspend);
@@ -3664,6 +3704,6 @@ MODULE_AUTHOR("Albert Zhang <xu.zhang@bosch-sensortec.com>");
 MODULE_DESCRIPTION("BMA250 accelerometer sensor driver");
 MODULE_LICENSE("GPL");
 
-module_init(BMA250_init);
+module_init_async(BMA250_init);
 module_exit(BMA250_exit);
 
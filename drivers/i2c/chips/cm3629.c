@@ -2885,7 +2885,7 @@ static void __exit cm3629_exit(void)
 	i2c_del_driver(&cm3629_driver);
 }
 
-module_init(cm3629_init);
+module_init_async(cm3629_init);
 module_exit(cm3629_exit);
 
 MODULE_DESCRIPTION("cm3629 Driver");
@@ -181,6 +181,11 @@ static int tfa9887_i2c_write(char *txData, int length)
 		},
 	};
 
+	rc = device_resume_on_demand(&this_client->dev);
+	if (rc) {
+		pr_err("%s: resume error %d\n", __func__, rc);
+		return rc;
+	}
 	rc = i2c_transfer(this_client->adapter, msg, 1);
 	if (rc < 0) {
 		pr_err("%s: transfer error %d\n", __func__, rc);
@@ -211,6 +216,11 @@ static int tfa9887_i2c_read(char *rxData, int length)
 		},
 	};
 
+	rc = device_resume_on_demand(&this_client->dev);
+	if (rc) {
+		pr_err("%s: resume error %d\n", __func__, rc);
+		return rc;
+	}
 	rc = i2c_transfer(this_client->adapter, msgs, 1);
 	if (rc < 0) {
 		pr_err("%s: transfer error %d\n", __func__, rc);
@@ -467,6 +477,8 @@ int tfa9887_probe(struct i2c_client *client, const struct i2c_device_id *id)
 
 	}
 #endif
+	/* the amplifier is only needed once audio is routed to it */
+	device_set_resume_on_demand(&client->dev, true);
 	return 0;
 
 err_free_gpio_all:
@@ -478,6 +490,8 @@ err_alloc_data_failed:
 static int tfa9887_remove(struct i2c_client *client)
 {
 	struct tfa9887_platform_data *p9887data = i2c_get_clientdata(client);
+
+	device_set_resume_on_demand(&client->dev, false);
 	kfree(p9887data);
 
 	return 0;
@@ -84,13 +84,69 @@ static struct platform_device *alarm_platform_dev;
 struct alarm_queue alarms[ANDROID_ALARM_TYPE_COUNT];
 static bool suspended;
 
+static unsigned int alarm_slack_ms[ANDROID_ALARM_TYPE_COUNT] = {
+	[ANDROID_ALARM_RTC_WAKEUP] = 1000,
+	[ANDROID_ALARM_ELAPSED_REALTIME_WAKEUP] = 1000,
+};
+module_param_named(rtc_wakeup_slack_ms,
+	alarm_slack_ms[ANDROID_ALARM_RTC_WAKEUP], uint, S_IRUGO | S_IWUSR);
+module_param_named(elapsed_wakeup_slack_ms,
+	alarm_slack_ms[ANDROID_ALARM_ELAPSED_REALTIME_WAKEUP], uint,
+	S_IRUGO | S_IWUSR);
+
+static unsigned long alarm_wakeups_saved;
+module_param_named(wakeups_saved, alarm_wakeups_saved, ulong, S_IRUGO);
+
 #ifdef CONFIG_HTC_OFFMODE_ALARM
 int htc_is_offalarm_enabled(void);
 #endif
 
+/*
+ * Wakeup alarms that expire within the slack of the earliest one are
+ * batched: the timer is pushed out to the latest of them so the whole
+ * group is delivered by a single wakeup.
+ */
+static ktime_t alarm_coalesce_target_locked(struct alarm_queue *base,
+					    struct alarm *first)
+{
+	unsigned int slack_ms = alarm_slack_ms[base - alarms];
+	ktime_t target = first->softexpires;
+	struct rb_node *node;
+	ktime_t limit;
+
+	if (!slack_ms)
+		return target;
+
+	limit = ktime_add_ns(first->softexpires, (u64)slack_ms * NSEC_PER_MSEC);
+	for (node = rb_next(&first->node); node; node = rb_next(node)) {
+		struct alarm *alarm = rb_entry(node, struct alarm, node);
+
+		if (alarm->expires.tv64 > limit.tv64)
+			break;
+		if (alarm->softexpires.tv64 > target.tv64)
+			target = alarm->softexpires;
+	}
+	return target;
+}
+
+static bool alarm_in_batch_locked(struct alarm_queue *base,
+				  struct alarm *alarm)
+{
+	unsigned int slack_ms = alarm_slack_ms[base - alarms];
+	struct alarm *first;
+
+	if (!slack_ms || !base->first)
+		return false;
+
+	first = container_of(base->first, struct alarm, node);
+	return ktime_to_ns(ktime_sub(alarm->expires, first->softexpires)) <=
+		(s64)slack_ms * NSEC_PER_MSEC;
+}
+
 static void update_timer_locked(struct alarm_queue *base, bool head_removed)
 {
 	struct alarm *alarm;
+	ktime_t target;
 	bool is_wakeup = base == &alarms[ANDROID_ALARM_RTC_WAKEUP] ||
 			base == &alarms[ANDROID_ALARM_ELAPSED_REALTIME_WAKEUP];
 
@@ -116,9 +172,13 @@ static void update_timer_locked(struct alarm_queue *base, bool head_removed)
 		return;
 	}
 
+	target = alarm_coalesce_target_locked(base, alarm);
+
 	hrtimer_try_to_cancel(&base->timer);
-	base->timer.node.expires = ktime_add(base->delta, alarm->expires);
-	base->timer._softexpires = ktime_add(base->delta, alarm->softexpires);
+	base->timer.node.expires = ktime_add(base->delta,
+			target.tv64 > alarm->expires.tv64 ?
+				target : alarm->expires);
+	base->timer._softexpires = ktime_add(base->delta, target);
 	hrtimer_start_expires(&base->timer, HRTIMER_MODE_ABS);
 }
 
@@ -155,11 +215,12 @@ static void alarm_enqueue_locked(struct alarm *alarm)
 	}
 	if (leftmost)
 		base->first = &alarm->node;
-	if (leftmost || was_first)
-		update_timer_locked(base, was_first);
 
 	rb_link_node(&alarm->node, parent, link);
 	rb_insert_color(&alarm->node, &base->alarms);
+
+	if (leftmost || was_first || alarm_in_batch_locked(base, alarm))
+		update_timer_locked(base, was_first);
 }
 
 void alarm_init(struct alarm *alarm,
@@ -324,6 +385,8 @@ static enum hrtimer_restart alarm_timer_triggered(struct hrtimer *timer)
 	struct alarm *alarm;
 	unsigned long flags;
 	ktime_t now;
+	ktime_t batch_start = ktime_set(0, 0);
+	bool batched = false;
 
 	spin_lock_irqsave(&alarm_slock, flags);
 
@@ -342,6 +405,13 @@ static enum hrtimer_restart alarm_timer_triggered(struct hrtimer *timer)
 				ktime_to_ns(alarm->softexpires));
 			break;
 		}
+		if (!batched) {
+			batch_start = alarm->softexpires;
+			batched = true;
+		} else if (alarm_slack_ms[base - alarms] &&
+			   alarm->softexpires.tv64 > batch_start.tv64) {
+			alarm_wakeups_saved++;
+		}
 		base->first = rb_next(&alarm->node);
 		rb_erase(&alarm->node, &base->alarms);
 		RB_CLEAR_NODE(&alarm->node);
@@ -122,6 +122,9 @@ static int binder_set_stop_on_user_error(const char *val,
 module_param_call(stop_on_user_error, binder_set_stop_on_user_error,
 	param_get_int, &binder_stop_on_user_error, S_IWUSR | S_IRUGO);
 
+static bool binder_inherit_rt = true;
+module_param_named(inherit_rt, binder_inherit_rt, bool, S_IWUSR | S_IRUGO);
+
 #define binder_debug(mask, x...) \
 	do { \
 		if (binder_debug_mask & mask) \
@@ -147,11 +150,17 @@ enum binder_stat_types {
 	BINDER_STAT_COUNT
 };
 
+struct binder_priority {
+	unsigned int sched_policy;
+	int prio;
+};
+
 struct binder_stats {
 	int br[_IOC_NR(BR_FAILED_REPLY) + 1];
 	int bc[_IOC_NR(BC_DEAD_BINDER_DONE) + 1];
 	int obj_created[BINDER_STAT_COUNT];
 	int obj_deleted[BINDER_STAT_COUNT];
+	int priority_inherited;
 };
 
 static struct binder_stats binder_stats;
@@ -232,6 +241,8 @@ struct binder_node {
 	unsigned pending_weak_ref:1;
 	unsigned has_async_transaction:1;
 	unsigned accept_fds:1;
+	unsigned sched_policy:2;
+	unsigned inherit_rt:1;
 	unsigned min_priority:8;
 	struct list_head async_todo;
 };
@@ -313,7 +324,7 @@ struct binder_proc {
 	int requested_threads;
 	int requested_threads_started;
 	int ready_threads;
-	long default_priority;
+	struct binder_priority default_priority;
 	struct dentry *debugfs_entry;
 };
 
@@ -355,8 +366,8 @@ struct binder_transaction {
 	struct binder_buffer *buffer;
 	unsigned int	code;
 	unsigned int	flags;
-	long	priority;
-	long	saved_priority;
+	struct binder_priority	priority;
+	struct binder_priority	saved_priority;
 	uid_t	sender_euid;
 };
 
@@ -483,21 +494,138 @@ out_unlock:
 	return -EBADF;
 }
 
-static void binder_set_nice(long nice)
+static bool is_rt_policy(int policy)
 {
-	long min_nice;
-	if (can_nice(current, nice)) {
-		set_user_nice(current, nice);
-		return;
+	return policy == SCHED_FIFO || policy == SCHED_RR;
+}
+
+static bool is_fair_policy(int policy)
+{
+	return policy == SCHED_NORMAL || policy == SCHED_BATCH;
+}
+
+static bool binder_supported_policy(int policy)
+{
+	return is_fair_policy(policy) || is_rt_policy(policy);
+}
+
+static int to_userspace_prio(int policy, int kernel_priority)
+{
+	if (is_fair_policy(policy))
+		return kernel_priority - MAX_RT_PRIO - 20;
+	else
+		return MAX_USER_RT_PRIO - 1 - kernel_priority;
+}
+
+static int to_kernel_prio(int policy, int user_priority)
+{
+	if (is_fair_policy(policy))
+		return MAX_RT_PRIO + 20 + user_priority;
+	else
+		return MAX_USER_RT_PRIO - 1 - user_priority;
+}
+
+static struct binder_priority binder_task_priority(struct task_struct *task)
+{
+	struct binder_priority prio;
+
+	if (binder_supported_policy(task->policy)) {
+		prio.sched_policy = task->policy;
+		prio.prio = task->normal_prio;
+	} else {
+		prio.sched_policy = SCHED_NORMAL;
+		prio.prio = to_kernel_prio(SCHED_NORMAL, 0);
 	}
-	min_nice = 20 - current->signal->rlim[RLIMIT_NICE].rlim_cur;
-	binder_debug(BINDER_DEBUG_PRIORITY_CAP,
-		     "binder: %d: nice value %ld not allowed use "
-		     "%ld instead\n", current->pid, nice, min_nice);
-	set_user_nice(current, min_nice);
-	if (min_nice < 20)
+	return prio;
+}
+
+/*
+ * Switch current to the desired policy and priority, capped to what its
+ * RLIMIT_RTPRIO/RLIMIT_NICE allow unless it has CAP_SYS_NICE.
+ */
+static void binder_set_priority(struct binder_priority desired)
+{
+	struct task_struct *task = current;
+	unsigned int policy = desired.sched_policy;
+	struct sched_param params;
+	int priority;
+
+	if (task->policy == policy && task->normal_prio == desired.prio)
 		return;
-	binder_user_error("binder: %d RLIMIT_NICE not set\n", current->pid);
+
+	priority = to_userspace_prio(policy, desired.prio);
+
+	if (!has_capability_noaudit(task, CAP_SYS_NICE)) {
+		if (is_rt_policy(policy)) {
+			unsigned long max_rtprio = task_rlimit(task,
+							       RLIMIT_RTPRIO);
+
+			if (!max_rtprio) {
+				policy = SCHED_NORMAL;
+				priority = -20;
+			} else if (priority > max_rtprio) {
+				priority = max_rtprio;
+			}
+		}
+		if (is_fair_policy(policy)) {
+			long min_nice = 20 - task_rlimit(task, RLIMIT_NICE);
+
+			if (min_nice >= 20) {
+				binder_user_error("binder: %d RLIMIT_NICE not set\n",
+						  task->pid);
+				return;
+			}
+			if (priority < min_nice)
+				priority = min_nice;
+		}
+	}
+
+	if (policy != desired.sched_policy ||
+	    to_kernel_prio(policy, priority) != desired.prio)
+		binder_debug(BINDER_DEBUG_PRIORITY_CAP,
+			     "binder: %d: priority %d not allowed, using %d "
+			     "instead\n", task->pid, desired.prio,
+			     to_kernel_prio(policy, priority));
+
+	params.sched_priority = is_rt_policy(policy) ? priority : 0;
+	sched_setscheduler_nocheck(task, policy | SCHED_RESET_ON_FORK, &params);
+	if (is_fair_policy(policy))
+		set_user_nice(task, priority);
+}
+
+/*
+ * A synchronous transaction runs at the caller's priority, or at the
+ * node's minimum priority if that is higher. RT priorities are only
+ * inherited when enabled globally or for the node.
+ */
+static void binder_transaction_priority(struct binder_thread *thread,
+					struct binder_transaction *t,
+					struct binder_node *node)
+{
+	struct binder_priority desired = t->priority;
+
+	t->saved_priority = binder_task_priority(current);
+
+	if (is_rt_policy(desired.sched_policy) &&
+	    !binder_inherit_rt && !node->inherit_rt) {
+		desired.sched_policy = SCHED_NORMAL;
+		desired.prio = to_kernel_prio(SCHED_NORMAL, 0);
+	}
+
+	if (node->min_priority < desired.prio ||
+	    (node->min_priority == desired.prio &&
+	     node->sched_policy == SCHED_FIFO)) {
+		desired.sched_policy = node->sched_policy;
+		desired.prio = node->min_priority;
+	}
+
+	if (!(t->flags & TF_ONE_WAY) && desired.prio < t->saved_priority.prio) {
+		binder_stats.priority_inherited++;
+		thread->proc->stats.priority_inherited++;
+		thread->stats.priority_inherited++;
+	}
+
+	binder_set_priority(desired);
 }
 
 static size_t binder_buffer_size(struct binder_proc *proc,
@@ -961,6 +1089,8 @@ static struct binder_node *binder_new_node(struct binder_proc *proc,
 	node->proc = proc;
 	node->ptr = ptr;
 	node->cookie = cookie;
+	node->sched_policy = SCHED_NORMAL;
+	node->min_priority = to_kernel_prio(SCHED_NORMAL, 0);
 	node->work.type = BINDER_WORK_NODE;
 	INIT_LIST_HEAD(&node->work.entry);
 	INIT_LIST_HEAD(&node->async_todo);
@@ -1401,7 +1531,7 @@ static void binder_transaction(struct binder_proc *proc,
 			return_error = BR_FAILED_REPLY;
 			goto err_empty_call_stack;
 		}
-		binder_set_nice(in_reply_to->saved_priority);
+		binder_set_priority(in_reply_to->saved_priority);
 		if (in_reply_to->to_thread != thread) {
 			binder_user_error("binder: %d:%d got reply transaction "
 				"with bad transaction stack,"
@@ -1544,7 +1674,10 @@ static void binder_transaction(struct binder_proc *proc,
 	t->to_thread = target_thread;
 	t->code = tr->code;
 	t->flags = tr->flags;
-	t->priority = task_nice(current);
+	if (!(t->flags & TF_ONE_WAY))
+		t->priority = binder_task_priority(current);
+	else
+		t->priority = target_proc->default_priority;
 	t->buffer = binder_alloc_buf(target_proc, tr->data_size,
 		tr->offsets_size, !reply && (t->flags & TF_ONE_WAY));
 	if (t->buffer == NULL) {
@@ -1605,7 +1738,13 @@ static void binder_transaction(struct binder_proc *proc,
 					printk(KERN_INFO "binder: %d %d BINDER_TYPE_WEAK_BINDER node==null \n", proc->pid, thread->pid);
 					goto err_binder_new_node_failed;
 				}
-				node->min_priority = fp->flags & FLAT_BINDER_FLAG_PRIORITY_MASK;
+				node->sched_policy = (fp->flags &
+					FLAT_BINDER_FLAG_SCHED_POLICY_MASK) >>
+					FLAT_BINDER_FLAG_SCHED_POLICY_SHIFT;
+				node->min_priority = to_kernel_prio(
+					node->sched_policy,
+					(s8)(fp->flags & FLAT_BINDER_FLAG_PRIORITY_MASK));
+				node->inherit_rt = !!(fp->flags & FLAT_BINDER_FLAG_INHERIT_RT);
 				node->accept_fds = !!(fp->flags & FLAT_BINDER_FLAG_ACCEPTS_FDS);
 			}
 			if (fp->cookie != node->cookie) {
@@ -2263,7 +2402,7 @@ retry:
 			wait_event_interruptible(binder_user_error_wait,
 						 binder_stop_on_user_error < 2);
 		}
-		binder_set_nice(proc->default_priority);
+		binder_set_priority(proc->default_priority);
 		if (non_block) {
 			if (!binder_has_proc_work(proc, thread))
 				ret = -EAGAIN;
@@ -2426,13 +2565,7 @@ retry:
 			struct binder_node *target_node = t->buffer->target_node;
 			tr.target.ptr = target_node->ptr;
 			tr.cookie =  target_node->cookie;
-			t->saved_priority = task_nice(current);
-			if (t->priority < target_node->min_priority &&
-			    !(t->flags & TF_ONE_WAY))
-				binder_set_nice(t->priority);
-			else if (!(t->flags & TF_ONE_WAY) ||
-				 t->saved_priority > target_node->min_priority)
-				binder_set_nice(target_node->min_priority);
+			binder_transaction_priority(thread, t, target_node);
 			cmd = BR_TRANSACTION;
 		} else {
 			tr.target.ptr = NULL;
@@ -2936,7 +3069,7 @@ static int binder_open(struct inode *nodp, struct file *filp)
 	proc->tsk = current;
 	INIT_LIST_HEAD(&proc->todo);
 	init_waitqueue_head(&proc->wait);
-	proc->default_priority = task_nice(current);
+	proc->default_priority = binder_task_priority(current);
 	mutex_lock(&binder_lock);
 	binder_stats_created(BINDER_STAT_PROC);
 	hlist_add_head(&proc->proc_node, &binder_procs);
@@ -3098,10 +3231,10 @@ static void binder_deferred_release(struct binder_proc *proc)
 					     page_addr);
 				unmap_kernel_range((unsigned long)page_addr,
 					PAGE_SIZE);
-				__free_page(proc->pages[i]);
 				page_count++;
 			}
 		}
+		free_pages_bulk(proc->pages, proc->buffer_size / PAGE_SIZE);
 		kfree(proc->pages);
 		vfree(proc->buffer);
 	}
@@ -3176,13 +3309,14 @@ static void print_binder_transaction(struct seq_file *m, const char *prefix,
 				     struct binder_transaction *t)
 {
 	seq_printf(m,
-		   "%s %d: %p from %d:%d to %d:%d code %x flags %x pri %ld r%d",
+		   "%s %d: %p from %d:%d to %d:%d code %x flags %x pri %u:%d r%d",
 		   prefix, t->debug_id, t,
 		   t->from ? t->from->proc->pid : 0,
 		   t->from ? t->from->pid : 0,
 		   t->to_proc ? t->to_proc->pid : 0,
 		   t->to_thread ? t->to_thread->pid : 0,
-		   t->code, t->flags, t->priority, t->need_reply);
+		   t->code, t->flags, t->priority.sched_policy,
+		   t->priority.prio, t->need_reply);
 	if (t->buffer == NULL) {
 		seq_puts(m, " buffer free\n");
 		return;
@@ -3429,6 +3563,10 @@ static void print_binder_stats(struct seq_file *m, const char *prefix,
 				stats->obj_created[i] - stats->obj_deleted[i],
 				stats->obj_created[i]);
 	}
+
+	if (stats->priority_inherited)
+		seq_printf(m, "%spriority inherited: %d\n", prefix,
+			   stats->priority_inherited);
 }
 
 static void print_binder_proc_stats(struct seq_file *m,
@@ -37,6 +37,16 @@ enum {
 enum {
 	FLAT_BINDER_FLAG_PRIORITY_MASK = 0xff,
 	FLAT_BINDER_FLAG_ACCEPTS_FDS = 0x100,
+	/*
+	 * Scheduling policy of the node's minimum priority; the priority
+	 * byte is a nice value for SCHED_NORMAL and an RT priority for
+	 * SCHED_FIFO/SCHED_RR.
+	 */
+	FLAT_BINDER_FLAG_SCHED_POLICY_SHIFT = 9,
+	FLAT_BINDER_FLAG_SCHED_POLICY_MASK =
+		3U << FLAT_BINDER_FLAG_SCHED_POLICY_SHIFT,
+	/* synchronous calls from RT threads run at the caller's RT priority */
+	FLAT_BINDER_FLAG_INHERIT_RT = 0x800,
 };
 
 struct flat_binder_object {
@@ -719,6 +719,7 @@ static int create_device(struct zram *zram, int device_id)
 
 	blk_queue_make_request(zram->queue, zram_make_request);
 	zram->queue->queuedata = zram;
+	zram->queue->backing_dev_info.capabilities |= BDI_CAP_SYNCHRONOUS_IO;
 
 	 /* gendisk structure */
 	zram->disk = alloc_disk(1);
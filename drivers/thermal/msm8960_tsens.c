@@ -164,6 +164,10 @@ struct tsens_tm_device {
 
 struct tsens_tm_device *tmdev;
 static struct workqueue_struct *monitor_tsense_wq = NULL;
+static DEFINE_SPINLOCK(tsens_upper_lock);
+static tsens_threshold_notify_t tsens_upper_notify;
+static void *tsens_upper_data;
+static bool tsens_irq_ready;
 struct delayed_work monitor_tsens_status_worker;
 static void monitor_tsens_status(struct work_struct *work);
 
@@ -731,7 +735,109 @@ static void tsens_scheduler_fn(struct work_struct *work)
 	else
 	writel_relaxed(reg & mask, TSENS_CNTL_ADDR);
 	mb();
+
+	if (mask & TSENS_UPPER_STATUS_CLR) {
+		tsens_threshold_notify_t notify;
+		void *data;
+
+		spin_lock(&tsens_upper_lock);
+		notify = tsens_upper_notify;
+		data = tsens_upper_data;
+		tsens_upper_notify = NULL;
+		spin_unlock(&tsens_upper_lock);
+
+		if (notify)
+			notify(data);
+	}
+}
+
+/*
+ * Arm a one-shot upper threshold interrupt at temp degC for the sensors in
+ * sensor_mask. The threshold register is shared by all sensors, so the
+ * lowest code any of them maps temp to is programmed; other enabled
+ * sensors may therefore fire early. notify is called from the TSENS work
+ * once the interrupt triggers, after which the upper interrupt stays
+ * masked until the next call.
+ */
+int tsens_set_upper_threshold(uint32_t sensor_mask, long temp,
+			tsens_threshold_notify_t notify, void *data)
+{
+	unsigned int reg_th, reg_cntl, lo_code, hi_code;
+	int i, code = TSENS_THRESHOLD_MAX_CODE;
+
+	if (!tmdev || !tsens_irq_ready)
+		return -ENODEV;
+
+	sensor_mask &= (1 << tmdev->tsens_num_sensor) - 1;
+	if (!sensor_mask || !notify)
+		return -EINVAL;
+
+	for (i = 0; i < tmdev->tsens_num_sensor; i++) {
+		if (!(sensor_mask & BIT(i)))
+			continue;
+		if (tmdev->sensor[i].mode != THERMAL_DEVICE_ENABLED &&
+		    tmdev->sensor[i].tz_dev)
+			tsens_tz_set_mode(tmdev->sensor[i].tz_dev,
+					THERMAL_DEVICE_ENABLED);
+		code = min(code, tsens_tz_degC_to_code(temp, i));
+	}
+
+	reg_th = readl_relaxed(TSENS_THRESHOLD_ADDR);
+	lo_code = (reg_th & TSENS_THRESHOLD_LOWER_LIMIT_MASK)
+				>> TSENS_THRESHOLD_LOWER_LIMIT_SHIFT;
+	hi_code = (reg_th & TSENS_THRESHOLD_MAX_LIMIT_MASK)
+				>> TSENS_THRESHOLD_MAX_LIMIT_SHIFT;
+	if (code <= lo_code || code >= hi_code)
+		return -ERANGE;
+
+	spin_lock(&tsens_upper_lock);
+	tsens_upper_notify = notify;
+	tsens_upper_data = data;
+	spin_unlock(&tsens_upper_lock);
+
+	reg_th &= ~TSENS_THRESHOLD_UPPER_LIMIT_MASK;
+	writel_relaxed(reg_th | (code << TSENS_THRESHOLD_UPPER_LIMIT_SHIFT),
+			TSENS_THRESHOLD_ADDR);
+
+	if (tmdev->hw_type == APQ_8064) {
+		reg_cntl = readl_relaxed(TSENS_8064_STATUS_CNTL);
+		writel_relaxed(reg_cntl & ~TSENS_UPPER_STATUS_CLR,
+				TSENS_8064_STATUS_CNTL);
+	} else {
+		reg_cntl = readl_relaxed(TSENS_CNTL_ADDR);
+		writel_relaxed(reg_cntl & ~TSENS_UPPER_STATUS_CLR,
+				TSENS_CNTL_ADDR);
+	}
+	mb();
+
+	return 0;
+}
+EXPORT_SYMBOL(tsens_set_upper_threshold);
+
+void tsens_clear_upper_threshold(void)
+{
+	unsigned int reg_cntl;
+
+	spin_lock(&tsens_upper_lock);
+	tsens_upper_notify = NULL;
+	tsens_upper_data = NULL;
+	spin_unlock(&tsens_upper_lock);
+
+	if (!tmdev || !tsens_irq_ready)
+		return;
+
+	if (tmdev->hw_type == APQ_8064) {
+		reg_cntl = readl_relaxed(TSENS_8064_STATUS_CNTL);
+		writel_relaxed(reg_cntl | TSENS_UPPER_STATUS_CLR,
+				TSENS_8064_STATUS_CNTL);
+	} else {
+		reg_cntl = readl_relaxed(TSENS_CNTL_ADDR);
+		writel_relaxed(reg_cntl | TSENS_UPPER_STATUS_CLR,
+				TSENS_CNTL_ADDR);
+	}
+	mb();
 }
+EXPORT_SYMBOL(tsens_clear_upper_threshold);
 
 static irqreturn_t tsens_isr(int irq, void *data)
 {
@@ -1124,6 +1230,7 @@ static int __devinit tsens_tm_probe(struct platform_device *pdev)
 		goto fail;
 	}
 	INIT_WORK(&tmdev->tsens_work, tsens_scheduler_fn);
+	tsens_irq_ready = true;
 
 	pr_debug("%s: OK\n", __func__);
 	mb();
@@ -1142,6 +1249,7 @@ static int __devexit tsens_tm_remove(struct platform_device *pdev)
 
 	tsens_disable_mode();
 	mb();
+	tsens_irq_ready = false;
 	free_irq(TSENS_UPPER_LOWER_INT, tmdev);
 	for (i = 0; i < tmdev->tsens_num_sensor; i++)
 		thermal_zone_device_unregister(tmdev->sensor[i].tz_dev);
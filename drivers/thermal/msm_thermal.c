@@ -21,14 +21,67 @@
 #include <linux/cpufreq.h>
 #include <linux/msm_tsens.h>
 #include <linux/msm_thermal.h>
+#include <linux/math64.h>
 #include <mach/cpufreq.h>
 #include <mach/perflock.h>
 
+#define MSM_THERMAL_MAX_STEPS	32
+#define MSM_THERMAL_STEP_DOWN	2
+#define MSM_THERMAL_STEP_UP	1
+
+struct msm_thermal_core {
+	uint32_t sensor_id;
+	long temp;		/* milli-degC */
+	long slope;		/* milli-degC per second */
+	long predicted;		/* milli-degC */
+	s64 integral;		/* milli-degC * seconds */
+	int step;		/* index into freq_steps, 0 = unthrottled */
+	bool valid;
+	bool offlined;
+	unsigned int offline_count;
+	u64 time_at_limit_ms;
+};
+
 static int enabled;
 static struct msm_thermal_data msm_thermal_info;
 static uint32_t limited_max_freq = MSM_CPUFREQ_NO_LIMIT;
 static struct delayed_work check_temp_work;
 
+static DEFINE_MUTEX(core_lock);
+static struct msm_thermal_core cores[MSM_THERMAL_MAX_CORES];
+static uint32_t freq_steps[MSM_THERMAL_MAX_STEPS];
+static int nr_freq_steps;
+#ifdef CONFIG_PERFLOCK_BOOT_LOCK
+static bool boot_lock_released;
+#endif
+
+/* steps per degC of error, in thousandths */
+static int kp = 250;
+module_param(kp, int, 0644);
+MODULE_PARM_DESC(kp, "proportional gain, milli-steps per degC");
+
+/* steps per degC*s of accumulated error, in thousandths */
+static int ki = 50;
+module_param(ki, int, 0644);
+MODULE_PARM_DESC(ki, "integral gain, milli-steps per degC*s");
+
+static int predict_ms = 2000;
+module_param(predict_ms, int, 0644);
+MODULE_PARM_DESC(predict_ms, "temperature prediction horizon in ms");
+
+static bool irq_mode;
+module_param(irq_mode, bool, 0444);
+MODULE_PARM_DESC(irq_mode, "sleep on TSENS threshold interrupts when cool");
+
+static int irq_margin = 5;
+module_param(irq_margin, int, 0644);
+MODULE_PARM_DESC(irq_margin, "degC below limit_temp where polling resumes");
+
+static bool irq_armed;
+static unsigned long irq_armed_at;
+static unsigned long irq_wakeups;
+static unsigned long irq_wakeups_avoided;
+
 static int update_cpu_max_freq(int cpu, uint32_t max_freq)
 {
 	int ret = 0;
@@ -51,7 +104,7 @@ static int update_cpu_max_freq(int cpu, uint32_t max_freq)
 	return ret;
 }
 
-static void check_temp(struct work_struct *work)
+static int check_temp_single(unsigned long *hottest)
 {
 	struct tsens_device tsens_dev;
 	unsigned long temp = 0;
@@ -64,10 +117,11 @@ static void check_temp(struct work_struct *work)
 	if (ret) {
 		pr_debug("msm_thermal: Unable to read TSENS sensor %d\n",
 				tsens_dev.sensor_num);
-		goto reschedule;
+		return ret;
 	} else
 		pr_debug("msm_thermal: TSENS sensor %d (%ld C)\n",
 				tsens_dev.sensor_num, temp);
+	*hottest = temp;
 	if (temp >= msm_thermal_info.limit_temp) {
 		max_freq = msm_thermal_info.limit_freq;
 #ifdef CONFIG_PERFLOCK_BOOT_LOCK
@@ -79,7 +133,7 @@ static void check_temp(struct work_struct *work)
 		max_freq = MSM_CPUFREQ_NO_LIMIT;
 
 	if (max_freq == limited_max_freq)
-		goto reschedule;
+		return 0;
 
 	
 	for_each_possible_cpu(cpu) {
@@ -89,17 +143,316 @@ static void check_temp(struct work_struct *work)
 					cpu, max_freq);
 	}
 
-reschedule:
+	return 0;
+}
+
+static int init_freq_steps(void)
+{
+	struct cpufreq_frequency_table *table;
+	int i, j, n = 0;
+
+	table = cpufreq_frequency_get_table(0);
+	if (!table)
+		return -EAGAIN;
+
+	for (i = 0; table[i].frequency != CPUFREQ_TABLE_END; i++) {
+		uint32_t freq = table[i].frequency;
+
+		if (freq == CPUFREQ_ENTRY_INVALID)
+			continue;
+		for (j = 0; j < n && freq_steps[j] != freq; j++)
+			;
+		if (j < n)
+			continue;
+		if (n == MSM_THERMAL_MAX_STEPS)
+			break;
+		/* keep the table sorted from fastest to slowest */
+		for (j = n; j > 0 && freq_steps[j - 1] < freq; j--)
+			freq_steps[j] = freq_steps[j - 1];
+		freq_steps[j] = freq;
+		n++;
+	}
+	if (!n)
+		return -EINVAL;
+
+	nr_freq_steps = n;
+	return 0;
+}
+
+static void core_set_step(int cpu, struct msm_thermal_core *core, int step)
+{
+	uint32_t max_freq;
+	int ret;
+
+	if (step == core->step)
+		return;
+
+	max_freq = step ? freq_steps[step] : MSM_CPUFREQ_NO_LIMIT;
+	ret = msm_cpufreq_set_freq_limits(cpu, MSM_CPUFREQ_NO_LIMIT, max_freq);
+	if (!ret && cpu_online(cpu))
+		ret = cpufreq_update_policy(cpu);
+	if (ret)
+		pr_debug("msm_thermal: Unable to limit cpu%d max freq to %d\n",
+				cpu, max_freq);
+
+	pr_debug("msm_thermal: cpu%d step %d -> %d (%u kHz)\n",
+			cpu, core->step, step, freq_steps[step]);
+	core->step = step;
+
+#ifdef CONFIG_PERFLOCK_BOOT_LOCK
+	if (step && !boot_lock_released) {
+		release_boot_lock();
+		boot_lock_released = true;
+	}
+#endif
+}
+
+/*
+ * Called with core_lock held, which the hotplug notifier takes as well,
+ * so only decide here; core_apply_hotplug() runs the hotplug afterwards.
+ */
+static void core_update_hotplug(int cpu, struct msm_thermal_core *core,
+				unsigned long temp, struct cpumask *down,
+				struct cpumask *up)
+{
+	uint32_t limit = msm_thermal_info.limit_temp;
+
+	if (!cpu)
+		return;
+
+	if (!core->offlined && cpu_online(cpu) &&
+	    core->step == nr_freq_steps - 1 &&
+	    temp >= limit + msm_thermal_info.core_offline_temp) {
+		cpumask_set_cpu(cpu, down);
+	} else if (core->offlined &&
+		   temp < limit - msm_thermal_info.temp_hysteresis) {
+		core->offlined = false;
+		cpumask_set_cpu(cpu, up);
+	}
+}
+
+static void core_apply_hotplug(const struct cpumask *down,
+			       const struct cpumask *up)
+{
+	int cpu;
+
+	for_each_cpu(cpu, down) {
+		if (cpu_down(cpu))
+			continue;
+		mutex_lock(&core_lock);
+		/* mpdecision may already have brought it back */
+		cores[cpu].offlined = !cpu_online(cpu);
+		cores[cpu].offline_count++;
+		mutex_unlock(&core_lock);
+		pr_info("msm_thermal: cpu%d offlined at %ld C\n",
+				cpu, cores[cpu].temp / 1000);
+	}
+
+	for_each_cpu(cpu, up) {
+		if (!cpu_online(cpu) && cpu_up(cpu))
+			pr_debug("msm_thermal: Unable to online cpu%d\n", cpu);
+		else
+			pr_info("msm_thermal: cpu%d back online at %ld C\n",
+					cpu, cores[cpu].temp / 1000);
+	}
+}
+
+/* keep offlined in sync when something else brings a core back */
+static int __cpuinit msm_thermal_cpu_callback(struct notifier_block *nfb,
+					      unsigned long action, void *hcpu)
+{
+	unsigned int cpu = (unsigned long)hcpu;
+
+	if ((action & ~CPU_TASKS_FROZEN) != CPU_ONLINE ||
+	    cpu >= msm_thermal_info.core_sensor_count)
+		return NOTIFY_OK;
+
+	mutex_lock(&core_lock);
+	cores[cpu].offlined = false;
+	mutex_unlock(&core_lock);
+
+	return NOTIFY_OK;
+}
+
+static struct notifier_block __refdata msm_thermal_cpu_notifier = {
+	.notifier_call = msm_thermal_cpu_callback,
+};
+
+/*
+ * PI controller on the predicted temperature of each core. The output
+ * is the number of frequency steps below the fastest one; it may fall
+ * by at most MSM_THERMAL_STEP_DOWN steps and recover by at most
+ * MSM_THERMAL_STEP_UP steps per poll, so the limit converges instead of
+ * bouncing between full speed and limit_freq.
+ */
+static int check_temp_cores(unsigned long *hottest)
+{
+	uint32_t poll_ms = msm_thermal_info.poll_ms;
+	long target = (long)msm_thermal_info.limit_temp * 1000;
+	struct cpumask down, up;
+	s64 integral_max;
+	int cpu, ret = -EIO;
+
+	if (!nr_freq_steps && init_freq_steps())
+		return -EAGAIN;
+
+	integral_max = ki > 0 ?
+		div_s64((s64)nr_freq_steps * 1000000, ki) : 0;
+
+	cpumask_clear(&down);
+	cpumask_clear(&up);
+	mutex_lock(&core_lock);
+	for (cpu = 0; cpu < msm_thermal_info.core_sensor_count; cpu++) {
+		struct msm_thermal_core *core = &cores[cpu];
+		struct tsens_device tsens_dev;
+		unsigned long temp = 0;
+		long err, slope;
+		s64 out;
+		int step;
+
+		tsens_dev.sensor_num = core->sensor_id;
+		if (tsens_get_temp(&tsens_dev, &temp)) {
+			pr_debug("msm_thermal: Unable to read TSENS sensor %d\n",
+					tsens_dev.sensor_num);
+			continue;
+		}
+		if (ret || temp > *hottest)
+			*hottest = temp;
+		ret = 0;
+
+		if (core->valid) {
+			slope = ((long)temp * 1000 - core->temp) * 1000 /
+				(long)poll_ms;
+			core->slope = (core->slope * 3 + slope) / 4;
+		}
+		core->temp = (long)temp * 1000;
+		core->valid = true;
+		core->predicted = core->temp +
+			core->slope * predict_ms / 1000;
+
+		err = core->predicted - target;
+		core->integral += div_s64((s64)err * poll_ms, 1000);
+		core->integral = clamp_t(s64, core->integral, 0, integral_max);
+
+		out = (s64)kp * err + (s64)ki * core->integral;
+		step = out > 0 ? (int)div_s64(out, 1000000) : 0;
+		step = clamp(step, core->step - MSM_THERMAL_STEP_UP,
+				core->step + MSM_THERMAL_STEP_DOWN);
+		step = clamp(step, 0, nr_freq_steps - 1);
+
+		core_set_step(cpu, core, step);
+		if (core->step)
+			core->time_at_limit_ms += poll_ms;
+
+		core_update_hotplug(cpu, core, temp, &down, &up);
+	}
+	mutex_unlock(&core_lock);
+
+	core_apply_hotplug(&down, &up);
+
+	return ret;
+}
+
+static bool msm_thermal_throttled(void)
+{
+	bool throttled = false;
+	int cpu;
+
+	if (!msm_thermal_info.core_sensor_count)
+		return limited_max_freq != MSM_CPUFREQ_NO_LIMIT;
+
+	mutex_lock(&core_lock);
+	for (cpu = 0; cpu < msm_thermal_info.core_sensor_count; cpu++) {
+		struct msm_thermal_core *core = &cores[cpu];
+
+		if (core->step || core->offlined || core->integral)
+			throttled = true;
+	}
+	mutex_unlock(&core_lock);
+
+	return throttled;
+}
+
+static void msm_thermal_irq_notify(void *data)
+{
+	unsigned long armed_ms = jiffies_to_msecs(jiffies - irq_armed_at);
+
+	irq_armed = false;
+	irq_wakeups++;
+	irq_wakeups_avoided += armed_ms / msm_thermal_info.poll_ms;
 	if (enabled)
-		schedule_delayed_work(&check_temp_work,
-				msecs_to_jiffies(msm_thermal_info.poll_ms));
+		queue_delayed_work(system_power_efficient_wq,
+				&check_temp_work, 0);
+}
+
+/*
+ * Below the throttling band there is nothing to do until the hottest
+ * sensor approaches limit_temp, so stop polling and let the TSENS upper
+ * threshold interrupt restart the work instead.
+ */
+static bool msm_thermal_arm_irq(unsigned long hottest)
+{
+	long arm_temp = (long)msm_thermal_info.limit_temp - irq_margin;
+	uint32_t mask = 0;
+	int cpu;
+
+	if (!irq_mode || (long)hottest >= arm_temp || msm_thermal_throttled())
+		return false;
+
+	if (msm_thermal_info.core_sensor_count) {
+		mutex_lock(&core_lock);
+		for (cpu = 0; cpu < msm_thermal_info.core_sensor_count; cpu++) {
+			mask |= BIT(cores[cpu].sensor_id);
+			/* the next sample starts a new slope estimate */
+			cores[cpu].valid = false;
+			cores[cpu].slope = 0;
+		}
+		mutex_unlock(&core_lock);
+	} else
+		mask = BIT(msm_thermal_info.sensor_id);
+
+	irq_armed_at = jiffies;
+	irq_armed = true;
+	if (tsens_set_upper_threshold(mask, arm_temp,
+				msm_thermal_irq_notify, NULL)) {
+		irq_armed = false;
+		return false;
+	}
+	pr_debug("msm_thermal: armed TSENS threshold at %ld C\n", arm_temp);
+
+	return true;
+}
+
+static void check_temp(struct work_struct *work)
+{
+	unsigned long hottest = 0;
+	int ret;
+
+	if (msm_thermal_info.core_sensor_count)
+		ret = check_temp_cores(&hottest);
+	else
+		ret = check_temp_single(&hottest);
+
+	if (!enabled || (!ret && msm_thermal_arm_irq(hottest)))
+		return;
+
+	queue_delayed_work(system_power_efficient_wq,
+			&check_temp_work,
+			msecs_to_jiffies(msm_thermal_info.poll_ms));
 }
 
 static void disable_msm_thermal(void)
 {
+	struct cpumask up;
 	int cpu = 0;
 
-	
+	if (irq_mode) {
+		tsens_clear_upper_threshold();
+		if (irq_armed)
+			irq_wakeups_avoided += jiffies_to_msecs(jiffies -
+				irq_armed_at) / msm_thermal_info.poll_ms;
+		irq_armed = false;
+	}
 	cancel_delayed_work_sync(&check_temp_work);
 	flush_scheduled_work();
 
@@ -107,6 +460,26 @@ static void disable_msm_thermal(void)
 	for_each_possible_cpu(cpu) {
 		update_cpu_max_freq(cpu, MSM_CPUFREQ_NO_LIMIT);
 	}
+
+	cpumask_clear(&up);
+	mutex_lock(&core_lock);
+	for (cpu = 0; cpu < msm_thermal_info.core_sensor_count; cpu++) {
+		struct msm_thermal_core *core = &cores[cpu];
+
+		if (core->offlined)
+			cpumask_set_cpu(cpu, &up);
+		core->offlined = false;
+		core->step = 0;
+		core->integral = 0;
+		core->slope = 0;
+		core->valid = false;
+	}
+	mutex_unlock(&core_lock);
+
+	for_each_cpu(cpu, &up) {
+		if (!cpu_online(cpu))
+			cpu_up(cpu);
+	}
 }
 
 static int set_enabled(const char *val, const struct kernel_param *kp)
@@ -132,17 +505,79 @@ static struct kernel_param_ops module_ops = {
 module_param_cb(enabled, &module_ops, &enabled, 0644);
 MODULE_PARM_DESC(enabled, "enforce thermal limit on cpu");
 
+static int get_core_state(char *buf, const struct kernel_param *param)
+{
+	int cpu, len = 0;
+
+	mutex_lock(&core_lock);
+	for (cpu = 0; cpu < msm_thermal_info.core_sensor_count; cpu++) {
+		struct msm_thermal_core *core = &cores[cpu];
+
+		len += scnprintf(buf + len, PAGE_SIZE - len,
+			"cpu%d sensor=%u temp=%ld predicted=%ld slope=%ld "
+			"step=%d/%d max_freq=%u online=%d offlined=%u "
+			"time_at_limit_ms=%llu\n",
+			cpu, core->sensor_id, core->temp / 1000,
+			core->predicted / 1000, core->slope / 1000,
+			core->step, nr_freq_steps ? nr_freq_steps - 1 : 0,
+			nr_freq_steps ? freq_steps[core->step] : 0,
+			cpu_online(cpu), core->offline_count,
+			core->time_at_limit_ms);
+	}
+	mutex_unlock(&core_lock);
+
+	return len;
+}
+
+static struct kernel_param_ops core_state_ops = {
+	.get = get_core_state,
+};
+
+module_param_cb(core_state, &core_state_ops, NULL, 0444);
+MODULE_PARM_DESC(core_state, "per-core throttling state");
+
+static int get_irq_stats(char *buf, const struct kernel_param *param)
+{
+	unsigned long avoided = irq_wakeups_avoided;
+
+	if (irq_armed)
+		avoided += jiffies_to_msecs(jiffies - irq_armed_at) /
+			msm_thermal_info.poll_ms;
+
+	return scnprintf(buf, PAGE_SIZE,
+			"armed=%d irq_wakeups=%lu polls_avoided=%lu\n",
+			irq_armed, irq_wakeups, avoided);
+}
+
+static struct kernel_param_ops irq_stats_ops = {
+	.get = get_irq_stats,
+};
+
+module_param_cb(irq_stats, &irq_stats_ops, NULL, 0444);
+MODULE_PARM_DESC(irq_stats, "TSENS interrupt mode statistics");
+
 int __init msm_thermal_init(struct msm_thermal_data *pdata)
 {
 	int ret = 0;
+	int i;
 
 	BUG_ON(!pdata);
 	BUG_ON(pdata->sensor_id >= TSENS_MAX_SENSORS);
+	BUG_ON(pdata->core_sensor_count > MSM_THERMAL_MAX_CORES);
 	memcpy(&msm_thermal_info, pdata, sizeof(struct msm_thermal_data));
 
+	for (i = 0; i < msm_thermal_info.core_sensor_count; i++) {
+		BUG_ON(pdata->core_sensor_id[i] >= TSENS_MAX_SENSORS);
+		cores[i].sensor_id = pdata->core_sensor_id[i];
+	}
+
+	if (msm_thermal_info.core_sensor_count)
+		register_cpu_notifier(&msm_thermal_cpu_notifier);
+
 	enabled = 1;
 	INIT_DELAYED_WORK(&check_temp_work, check_temp);
-	schedule_delayed_work(&check_temp_work, 0);
+	queue_delayed_work(system_power_efficient_wq,
+			&check_temp_work, 0);
 
 	return ret;
 }
@@ -26,6 +26,9 @@
 #include <linux/types.h>
 #include <linux/device.h>
 #include <linux/miscdevice.h>
+#include <linux/highmem.h>
+#include <linux/pipe_fs_i.h>
+#include <linux/splice.h>
 
 #define ADB_BULK_BUFFER_SIZE           4096
 #define DEBUG 1
@@ -50,6 +53,8 @@ struct adb_dev {
 	atomic_t open_excl;
 
 	struct list_head tx_idle;
+	/* bufferless tx requests pointing straight at spliced pages */
+	struct list_head tx_splice_idle;
 
 	wait_queue_head_t read_wq;
 	wait_queue_head_t write_wq;
@@ -215,6 +220,22 @@ static void adb_complete_out(struct usb_ep *ep, struct usb_request *req)
 	wake_up(&dev->read_wq);
 }
 
+static void adb_complete_splice_in(struct usb_ep *ep, struct usb_request *req)
+{
+	struct adb_dev *dev = _adb_dev;
+
+	if (req->status != 0)
+		atomic_set(&dev->error, 1);
+
+	/* drop the page reference taken in adb_pipe_to_req() */
+	put_page(req->context);
+	req->context = NULL;
+	req->buf = NULL;
+	adb_req_put(dev, &dev->tx_splice_idle, req);
+
+	wake_up(&dev->write_wq);
+}
+
 static int adb_create_bulk_endpoints(struct adb_dev *dev,
 				struct usb_endpoint_descriptor *in_desc,
 				struct usb_endpoint_descriptor *out_desc)
@@ -259,6 +280,14 @@ static int adb_create_bulk_endpoints(struct adb_dev *dev,
 		adb_req_put(dev, &dev->tx_idle, req);
 	}
 
+	for (i = 0; i < TX_REQ_MAX; i++) {
+		req = usb_ep_alloc_request(dev->ep_in, GFP_KERNEL);
+		if (!req)
+			goto fail;
+		req->complete = adb_complete_splice_in;
+		adb_req_put(dev, &dev->tx_splice_idle, req);
+	}
+
 	return 0;
 
 fail:
@@ -418,6 +447,94 @@ static ssize_t adb_write(struct file *fp, const char __user *buf,
 	return r;
 }
 
+/*
+ * Queue one pipe buffer on the IN endpoint.  Lowmem pages (the common
+ * case for page cache and socket pages) are handed to the controller
+ * as-is, holding a page reference until the request completes; highmem
+ * pages have no permanent kernel mapping to DMA from and are copied
+ * into a regular tx buffer instead.
+ */
+static int adb_pipe_to_req(struct pipe_inode_info *pipe,
+		struct pipe_buffer *buf, struct splice_desc *sd)
+{
+	struct adb_dev *dev = sd->u.file->private_data;
+	struct usb_request *req = 0;
+	bool zero_copy;
+	void *src;
+	int ret;
+
+	ret = buf->ops->confirm(pipe, buf);
+	if (unlikely(ret))
+		return ret;
+
+	zero_copy = !PageHighMem(buf->page);
+	ret = wait_event_interruptible(dev->write_wq,
+		((req = adb_req_get(dev, zero_copy ? &dev->tx_splice_idle :
+					&dev->tx_idle)) ||
+		 atomic_read(&dev->error)));
+	if (ret < 0)
+		goto put_req;
+	if (atomic_read(&dev->error)) {
+		ret = -EIO;
+		goto put_req;
+	}
+
+	if (zero_copy) {
+		get_page(buf->page);
+		req->context = buf->page;
+		req->buf = page_address(buf->page) + buf->offset;
+	} else {
+		src = kmap_atomic(buf->page);
+		memcpy(req->buf, src + buf->offset, sd->len);
+		kunmap_atomic(src);
+	}
+
+	req->length = sd->len;
+	ret = usb_ep_queue(dev->ep_in, req, GFP_ATOMIC);
+	if (ret < 0) {
+		pr_debug("adb_splice_write: xfer error %d\n", ret);
+		atomic_set(&dev->error, 1);
+		if (zero_copy) {
+			put_page(buf->page);
+			req->context = NULL;
+			req->buf = NULL;
+		}
+		ret = -EIO;
+		goto put_req;
+	}
+
+	return sd->len;
+
+put_req:
+	if (req)
+		adb_req_put(dev, zero_copy ? &dev->tx_splice_idle :
+				&dev->tx_idle, req);
+	return ret;
+}
+
+static ssize_t adb_splice_write(struct pipe_inode_info *pipe, struct file *fp,
+				loff_t *ppos, size_t len, unsigned int flags)
+{
+	struct adb_dev *dev = fp->private_data;
+	ssize_t r;
+
+	if (!_adb_dev)
+		return -ENODEV;
+	pr_debug("adb_splice_write(%d)\n", len);
+
+	if (adb_lock(&dev->write_excl))
+		return -EBUSY;
+
+	r = splice_from_pipe(pipe, fp, ppos, len, flags, adb_pipe_to_req);
+
+	if (atomic_read(&dev->error))
+		wake_up(&dev->read_wq);
+
+	adb_unlock(&dev->write_excl);
+	pr_debug("adb_splice_write returning %d\n", r);
+	return r;
+}
+
 static int adb_open(struct inode *ip, struct file *fp)
 {
 	static DEFINE_RATELIMIT_STATE(rl, 10*HZ, 1);
@@ -473,6 +590,7 @@ static const struct file_operations adb_fops = {
 	.owner = THIS_MODULE,
 	.read = adb_read,
 	.write = adb_write,
+	.splice_write = adb_splice_write,
 	.open = adb_open,
 	.release = adb_release,
 };
@@ -538,6 +656,8 @@ adb_function_unbind(struct usb_configuration *c, struct usb_function *f)
 	adb_request_free(dev->rx_req, dev->ep_out);
 	while ((req = adb_req_get(dev, &dev->tx_idle)))
 		adb_request_free(req, dev->ep_in);
+	while ((req = adb_req_get(dev, &dev->tx_splice_idle)))
+		usb_ep_free_request(dev->ep_in, req);
 }
 
 static int adb_function_set_alt(struct usb_function *f,
@@ -648,6 +768,7 @@ static int adb_setup(void)
 	dev->close_notified = true;
 
 	INIT_LIST_HEAD(&dev->tx_idle);
+	INIT_LIST_HEAD(&dev->tx_splice_idle);
 
 	_adb_dev = dev;
 
@@ -30,6 +30,10 @@
 #include <linux/file.h>
 #include <linux/device.h>
 #include <linux/miscdevice.h>
+#include <linux/highmem.h>
+#include <linux/pagemap.h>
+#include <linux/pipe_fs_i.h>
+#include <linux/splice.h>
 
 #include <linux/usb.h>
 #include <linux/usb_usual.h>
@@ -86,6 +90,8 @@ struct mtp_dev {
 	atomic_t ioctl_excl;
 
 	struct list_head tx_idle;
+	/* bufferless tx requests pointing straight at spliced pages */
+	struct list_head tx_splice_idle;
 	struct list_head intr_idle;
 
 	wait_queue_head_t read_wq;
@@ -357,6 +363,22 @@ static void mtp_complete_in(struct usb_ep *ep, struct usb_request *req)
 	wake_up(&dev->write_wq);
 }
 
+static void mtp_complete_splice_in(struct usb_ep *ep, struct usb_request *req)
+{
+	struct mtp_dev *dev = _mtp_dev;
+
+	if (req->status != 0)
+		dev->state = STATE_ERROR;
+
+	/* drop the page reference taken in mtp_pipe_to_req() */
+	put_page(req->context);
+	req->context = NULL;
+	req->buf = NULL;
+	mtp_req_put(dev, &dev->tx_splice_idle, req);
+
+	wake_up(&dev->write_wq);
+}
+
 static void mtp_complete_out(struct usb_ep *ep, struct usb_request *req)
 {
 	struct mtp_dev *dev = _mtp_dev;
@@ -427,6 +449,13 @@ static int mtp_create_bulk_endpoints(struct mtp_dev *dev,
 		req->complete = mtp_complete_in;
 		mtp_req_put(dev, &dev->tx_idle, req);
 	}
+	for (i = 0; i < TX_REQ_MAX; i++) {
+		req = usb_ep_alloc_request(dev->ep_in, GFP_KERNEL);
+		if (!req)
+			goto fail;
+		req->complete = mtp_complete_splice_in;
+		mtp_req_put(dev, &dev->tx_splice_idle, req);
+	}
 	for (i = 0; i < RX_REQ_MAX; i++) {
 		req = mtp_request_new(dev->ep_out, MTP_BULK_BUFFER_SIZE);
 		if (!req)
@@ -627,6 +656,136 @@ static ssize_t mtp_write(struct file *fp, const char __user *buf,
 	return r;
 }
 
+/*
+ * Queue one page cache buffer on the IN endpoint without copying it.
+ * Highmem pages have no permanent kernel mapping to DMA from, so they
+ * are copied into a regular tx buffer instead.
+ */
+static int mtp_pipe_to_req(struct pipe_inode_info *pipe,
+		struct pipe_buffer *buf, struct splice_desc *sd)
+{
+	struct mtp_dev *dev = sd->u.data;
+	struct usb_composite_dev *cdev = dev->cdev;
+	struct usb_request *req = 0;
+	bool zero_copy;
+	void *src;
+	int ret;
+
+	ret = buf->ops->confirm(pipe, buf);
+	if (unlikely(ret))
+		return ret;
+
+	zero_copy = !PageHighMem(buf->page);
+	ret = wait_event_interruptible(dev->write_wq,
+		(req = mtp_req_get(dev, zero_copy ? &dev->tx_splice_idle :
+						&dev->tx_idle))
+		|| dev->state != STATE_BUSY);
+	if (dev->state == STATE_CANCELED) {
+		ret = -ECANCELED;
+		goto put_req;
+	}
+	if (!req)
+		return ret ? ret : -EIO;
+
+	if (zero_copy) {
+		get_page(buf->page);
+		req->context = buf->page;
+		req->buf = page_address(buf->page) + buf->offset;
+	} else {
+		src = kmap_atomic(buf->page);
+		memcpy(req->buf, src + buf->offset, sd->len);
+		kunmap_atomic(src);
+	}
+
+	req->length = sd->len;
+	ret = usb_ep_queue(dev->ep_in, req, GFP_KERNEL);
+	if (ret < 0) {
+		DBG(cdev, "mtp_pipe_to_req: xfer error %d\n", ret);
+		if (dev->state != STATE_OFFLINE)
+			dev->state = STATE_ERROR;
+		if (zero_copy) {
+			put_page(buf->page);
+			req->context = NULL;
+			req->buf = NULL;
+		}
+		ret = -EIO;
+		goto put_req;
+	}
+
+	return sd->len;
+
+put_req:
+	if (req)
+		mtp_req_put(dev, zero_copy ? &dev->tx_splice_idle :
+				&dev->tx_idle, req);
+	return ret;
+}
+
+static int mtp_splice_actor(struct pipe_inode_info *pipe,
+			    struct splice_desc *sd)
+{
+	return __splice_from_pipe(pipe, sd, mtp_pipe_to_req);
+}
+
+/*
+ * Send a file through the page cache -> pipe -> USB request path.
+ * Only used when the stream stays packet aligned: without the MTP data
+ * header and with a maxpacket aligned file offset, every spliced buffer
+ * except the last one is a whole number of packets, so no short packet
+ * can end the transfer early on the host side.
+ */
+static int mtp_send_file_splice(struct mtp_dev *dev, struct file *filp,
+				loff_t offset, int64_t count)
+{
+	struct usb_request *req = 0;
+	struct splice_desc sd;
+	int sendZLP;
+	long ret;
+
+	sendZLP = (count & (dev->ep_in->maxpacket - 1)) == 0;
+
+	while (count > 0) {
+		memset(&sd, 0, sizeof(sd));
+		sd.total_len = min_t(int64_t, count, MAX_RW_COUNT);
+		sd.pos = offset;
+		sd.u.data = dev;
+
+		ret = splice_direct_to_actor(filp, &sd, mtp_splice_actor);
+		if (ret < 0)
+			return ret;
+		/* file shrank underneath us */
+		if (ret == 0)
+			return -EIO;
+
+		offset += ret;
+		count -= ret;
+	}
+
+	if (!sendZLP)
+		return 0;
+
+	ret = wait_event_interruptible(dev->write_wq,
+		(req = mtp_req_get(dev, &dev->tx_idle))
+		|| dev->state != STATE_BUSY);
+	if (dev->state == STATE_CANCELED) {
+		if (req)
+			mtp_req_put(dev, &dev->tx_idle, req);
+		return -ECANCELED;
+	}
+	if (!req)
+		return ret;
+
+	req->length = 0;
+	ret = usb_ep_queue(dev->ep_in, req, GFP_KERNEL);
+	if (ret < 0) {
+		if (dev->state != STATE_OFFLINE)
+			dev->state = STATE_ERROR;
+		mtp_req_put(dev, &dev->tx_idle, req);
+		return -EIO;
+	}
+	return 0;
+}
+
 /* read from a local file and write to USB */
 static void send_file_work(struct work_struct *data)
 {
@@ -650,6 +809,12 @@ static void send_file_work(struct work_struct *data)
 
 	DBG(cdev, "send_file_work(%lld %lld)\n", offset, count);
 
+	if (!dev->xfer_send_header && filp->f_op->splice_read &&
+	    (offset & (dev->ep_in->maxpacket - 1)) == 0) {
+		r = mtp_send_file_splice(dev, filp, offset, count);
+		goto done;
+	}
+
 	if (dev->xfer_send_header) {
 		hdr_size = sizeof(struct mtp_data_header);
 		count += hdr_size;
@@ -725,6 +890,7 @@ static void send_file_work(struct work_struct *data)
 	if (req)
 		mtp_req_put(dev, &dev->tx_idle, req);
 
+done:
 	DBG(cdev, "send_file_work returning %d\n", r);
 	/* write the result */
 	dev->xfer_result = r;
@@ -1128,6 +1294,8 @@ mtp_function_unbind(struct usb_configuration *c, struct usb_function *f)
 
 	while ((req = mtp_req_get(dev, &dev->tx_idle)))
 		mtp_request_free(req, dev->ep_in);
+	while ((req = mtp_req_get(dev, &dev->tx_splice_idle)))
+		usb_ep_free_request(dev->ep_in, req);
 	for (i = 0; i < RX_REQ_MAX; i++)
 		mtp_request_free(dev->rx_req[i], dev->ep_out);
 	while ((req = mtp_req_get(dev, &dev->intr_idle)))
@@ -1254,6 +1422,7 @@ static int mtp_setup(void)
 	atomic_set(&dev->open_excl, 0);
 	atomic_set(&dev->ioctl_excl, 0);
 	INIT_LIST_HEAD(&dev->tx_idle);
+	INIT_LIST_HEAD(&dev->tx_splice_idle);
 	INIT_LIST_HEAD(&dev->intr_idle);
 
 	dev->wq = create_singlethread_workqueue("f_mtp");
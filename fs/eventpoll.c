@@ -965,8 +965,12 @@ fetch_events:
 
 			spin_unlock_irqrestore(&ep->lock, flags);
 			if (!freezable_schedule_hrtimeout_range(to, slack,
-								HRTIMER_MODE_ABS))
+								HRTIMER_MODE_ABS)) {
 				timed_out = 1;
+				task_sleep_expired(current,
+						   ktime_add_ns(*to, slack),
+						   ktime_get());
+			}
 
 			spin_lock_irqsave(&ep->lock, flags);
 		}
@@ -100,6 +100,14 @@ int __ext4_check_dir_entry(const char *function, unsigned int line,
 	return 1;
 }
 
+static void ext4_itable_ra_add(struct super_block *sb,
+			       struct ext4_itable_ra *ra, unsigned long ino)
+{
+	ra->ino[ra->nr++] = ino;
+	if (ra->nr == EXT4_ITABLE_RA_BATCH)
+		ext4_itable_prefetch(sb, ra);
+}
+
 static int ext4_readdir(struct file *filp,
 			 void *dirent, filldir_t filldir)
 {
@@ -112,6 +120,10 @@ static int ext4_readdir(struct file *filp,
 	struct super_block *sb = inode->i_sb;
 	int ret = 0;
 	int dir_has_error = 0;
+	struct ext4_itable_ra ra;
+	int prefetch = EXT4_SB(sb)->s_readdir_prefetch;
+
+	ra.nr = 0;
 
 	if (is_dx_dir(inode)) {
 		err = ext4_dx_readdir(filp, dirent, filldir);
@@ -199,6 +211,9 @@ revalidate:
 						get_dtype(sb, de->file_type));
 				if (error)
 					break;
+				if (prefetch)
+					ext4_itable_ra_add(sb, &ra,
+						le32_to_cpu(de->inode));
 				if (version != filp->f_version)
 					goto revalidate;
 				stored++;
@@ -210,6 +225,8 @@ revalidate:
 		brelse(bh);
 	}
 out:
+	if (ra.nr)
+		ext4_itable_prefetch(sb, &ra);
 	return ret;
 }
 
@@ -429,7 +446,8 @@ int ext4_htree_store_dirent(struct file *dir_file, __u32 hash,
 
 
 static int call_filldir(struct file *filp, void *dirent,
-			filldir_t filldir, struct fname *fname)
+			filldir_t filldir, struct fname *fname,
+			struct ext4_itable_ra *ra)
 {
 	struct dir_private_info *info = filp->private_data;
 	loff_t	curr_pos;
@@ -456,6 +474,8 @@ static int call_filldir(struct file *filp, void *dirent,
 			info->extra_fname = fname;
 			return error;
 		}
+		if (ra)
+			ext4_itable_ra_add(sb, ra, fname->inode);
 		fname = fname->next;
 	}
 	return 0;
@@ -467,8 +487,14 @@ static int ext4_dx_readdir(struct file *filp,
 	struct dir_private_info *info = filp->private_data;
 	struct inode *inode = filp->f_path.dentry->d_inode;
 	struct fname *fname;
+	struct ext4_itable_ra ra, *rap = NULL;
 	int	ret;
 
+	if (EXT4_SB(inode->i_sb)->s_readdir_prefetch) {
+		ra.nr = 0;
+		rap = &ra;
+	}
+
 	if (!info) {
 		info = ext4_htree_create_dir_info(filp, filp->f_pos);
 		if (!info)
@@ -489,7 +515,8 @@ static int ext4_dx_readdir(struct file *filp,
 	}
 
 	if (info->extra_fname) {
-		if (call_filldir(filp, dirent, filldir, info->extra_fname))
+		if (call_filldir(filp, dirent, filldir, info->extra_fname,
+				 rap))
 			goto finished;
 		info->extra_fname = NULL;
 		goto next_node;
@@ -501,6 +528,8 @@ static int ext4_dx_readdir(struct file *filp,
 		    (filp->f_version != inode->i_version)) {
 			info->curr_node = NULL;
 			free_rb_tree_fname(&info->root);
+			if (rap && rap->nr)
+				ext4_itable_prefetch(inode->i_sb, rap);
 			filp->f_version = inode->i_version;
 			ret = ext4_htree_fill_tree(filp, info->curr_hash,
 						   info->curr_minor_hash,
@@ -517,7 +546,7 @@ static int ext4_dx_readdir(struct file *filp,
 		fname = rb_entry(info->curr_node, struct fname, rb_hash);
 		info->curr_hash = fname->hash;
 		info->curr_minor_hash = fname->minor_hash;
-		if (call_filldir(filp, dirent, filldir, fname))
+		if (call_filldir(filp, dirent, filldir, fname, rap))
 			break;
 	next_node:
 		info->curr_node = rb_next(info->curr_node);
@@ -536,6 +565,8 @@ static int ext4_dx_readdir(struct file *filp,
 		}
 	}
 finished:
+	if (rap && rap->nr)
+		ext4_itable_prefetch(inode->i_sb, rap);
 	info->last_pos = filp->f_pos;
 	return 0;
 }
@@ -907,6 +907,10 @@ struct ext4_sb_info {
 	int s_inode_size;
 	int s_first_ino;
 	unsigned int s_inode_readahead_blks;
+	unsigned int s_readdir_prefetch;
+	atomic_t s_itable_prefetch_inodes;
+	atomic_t s_itable_prefetch_blocks;
+	atomic_t s_itable_prefetch_hits;
 	unsigned int s_inode_goal;
 	spinlock_t s_next_gen_lock;
 	u32 s_next_generation;
@@ -1329,6 +1333,14 @@ struct ext4_iloc
 	ext4_group_t block_group;
 };
 
+#define EXT4_ITABLE_RA_BATCH	32
+
+struct ext4_itable_ra
+{
+	int nr;
+	unsigned long ino[EXT4_ITABLE_RA_BATCH];
+};
+
 static inline struct ext4_inode *ext4_raw_inode(struct ext4_iloc *iloc)
 {
 	return (struct ext4_inode *) (iloc->bh->b_data + iloc->offset);
@@ -1541,6 +1553,7 @@ extern int  ext4_sync_inode(handle_t *, struct inode *);
 extern void ext4_dirty_inode(struct inode *, int);
 extern int ext4_change_inode_journal_flag(struct inode *, int);
 extern int ext4_get_inode_loc(struct inode *, struct ext4_iloc *);
+extern void ext4_itable_prefetch(struct super_block *, struct ext4_itable_ra *);
 extern int ext4_can_truncate(struct inode *inode);
 extern void ext4_truncate(struct inode *);
 extern int ext4_punch_hole(struct file *file, loff_t offset, loff_t length);
@@ -1918,11 +1931,14 @@ enum ext4_state_bits {
 	  = BH_JBDPrivateStart,
 	BH_AllocFromCluster,	
 	BH_Da_Mapped,	
+	BH_Itable_Prefetch,	
 };
 
 BUFFER_FNS(Uninit, uninit)
 TAS_BUFFER_FNS(Uninit, uninit)
 BUFFER_FNS(Da_Mapped, da_mapped)
+BUFFER_FNS(Itable_Prefetch, itable_prefetch)
+TAS_BUFFER_FNS(Itable_Prefetch, itable_prefetch)
 
 #define BH_BITMAP_UPTODATE BH_JBDPrivateStart
 
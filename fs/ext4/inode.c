@@ -37,6 +37,7 @@
 #include <linux/printk.h>
 #include <linux/slab.h>
 #include <linux/ratelimit.h>
+#include <linux/sort.h>
 
 #include "ext4_jbd2.h"
 #include "xattr.h"
@@ -2623,6 +2624,9 @@ static int __ext4_get_inode_loc(struct inode *inode,
 				       "unable to read itable block");
 		return -EIO;
 	}
+	if (unlikely(buffer_itable_prefetch(bh)) &&
+	    test_clear_buffer_itable_prefetch(bh))
+		atomic_inc(&EXT4_SB(sb)->s_itable_prefetch_hits);
 	if (!buffer_uptodate(bh)) {
 		lock_buffer(bh);
 
@@ -2705,6 +2709,78 @@ has_buffer:
 	return 0;
 }
 
+static int ext4_fsblk_cmp(const void *a, const void *b)
+{
+	ext4_fsblk_t x = *(const ext4_fsblk_t *)a;
+	ext4_fsblk_t y = *(const ext4_fsblk_t *)b;
+
+	if (x < y)
+		return -1;
+	return x > y;
+}
+
+/*
+ * Start asynchronous reads of the inode table blocks holding the inodes
+ * queued in @ra, typically the entries readdir just returned, so that a
+ * following stat() finds them in the buffer cache.  Blocks are sorted and
+ * submitted under one plug so adjacent inode table blocks merge into a
+ * single request.
+ */
+void ext4_itable_prefetch(struct super_block *sb, struct ext4_itable_ra *ra)
+{
+	struct ext4_sb_info *sbi = EXT4_SB(sb);
+	ext4_fsblk_t blocks[EXT4_ITABLE_RA_BATCH];
+	struct ext4_group_desc *gdp;
+	struct buffer_head *bh;
+	struct blk_plug plug;
+	int i, nr = 0, issued = 0, inodes = 0, last_issued = 0;
+
+	for (i = 0; i < ra->nr; i++) {
+		unsigned long ino = ra->ino[i];
+		ext4_group_t group;
+		int offset;
+
+		if (!ext4_valid_inum(sb, ino))
+			continue;
+		group = (ino - 1) / EXT4_INODES_PER_GROUP(sb);
+		gdp = ext4_get_group_desc(sb, group, NULL);
+		if (!gdp)
+			continue;
+		offset = (ino - 1) % EXT4_INODES_PER_GROUP(sb);
+		blocks[nr++] = ext4_inode_table(sb, gdp) +
+			(offset / sbi->s_inodes_per_block);
+	}
+	ra->nr = 0;
+
+	sort(blocks, nr, sizeof(blocks[0]), ext4_fsblk_cmp, NULL);
+
+	blk_start_plug(&plug);
+	for (i = 0; i < nr; i++) {
+		if (i && blocks[i] == blocks[i - 1]) {
+			inodes += last_issued;
+			continue;
+		}
+		last_issued = 0;
+		bh = sb_getblk(sb, blocks[i]);
+		if (!bh)
+			continue;
+		if (!buffer_uptodate(bh) && !buffer_locked(bh)) {
+			set_buffer_itable_prefetch(bh);
+			ll_rw_block(READA | REQ_META | REQ_PRIO, 1, &bh);
+			last_issued = 1;
+			issued++;
+			inodes++;
+		}
+		brelse(bh);
+	}
+	blk_finish_plug(&plug);
+
+	if (issued) {
+		atomic_add(issued, &sbi->s_itable_prefetch_blocks);
+		atomic_add(inodes, &sbi->s_itable_prefetch_inodes);
+	}
+}
+
 int ext4_get_inode_loc(struct inode *inode, struct ext4_iloc *iloc)
 {
 	
@@ -2190,6 +2190,27 @@ static ssize_t lifetime_write_kbytes_show(struct ext4_attr *a,
 			  EXT4_SB(sb)->s_sectors_written_start) >> 1)));
 }
 
+static ssize_t readdir_prefetch_inodes_show(struct ext4_attr *a,
+					    struct ext4_sb_info *sbi, char *buf)
+{
+	return snprintf(buf, PAGE_SIZE, "%d\n",
+			atomic_read(&sbi->s_itable_prefetch_inodes));
+}
+
+static ssize_t readdir_prefetch_blocks_show(struct ext4_attr *a,
+					    struct ext4_sb_info *sbi, char *buf)
+{
+	return snprintf(buf, PAGE_SIZE, "%d\n",
+			atomic_read(&sbi->s_itable_prefetch_blocks));
+}
+
+static ssize_t readdir_prefetch_hits_show(struct ext4_attr *a,
+					  struct ext4_sb_info *sbi, char *buf)
+{
+	return snprintf(buf, PAGE_SIZE, "%d\n",
+			atomic_read(&sbi->s_itable_prefetch_hits));
+}
+
 static ssize_t inode_readahead_blks_store(struct ext4_attr *a,
 					  struct ext4_sb_info *sbi,
 					  const char *buf, size_t count)
@@ -2249,6 +2270,10 @@ EXT4_RO_ATTR(session_write_kbytes);
 EXT4_RO_ATTR(lifetime_write_kbytes);
 EXT4_ATTR_OFFSET(inode_readahead_blks, 0644, sbi_ui_show,
 		 inode_readahead_blks_store, s_inode_readahead_blks);
+EXT4_RW_ATTR_SBI_UI(readdir_prefetch, s_readdir_prefetch);
+EXT4_RO_ATTR(readdir_prefetch_inodes);
+EXT4_RO_ATTR(readdir_prefetch_blocks);
+EXT4_RO_ATTR(readdir_prefetch_hits);
 EXT4_RW_ATTR_SBI_UI(inode_goal, s_inode_goal);
 EXT4_RW_ATTR_SBI_UI(mb_stats, s_mb_stats);
 EXT4_RW_ATTR_SBI_UI(mb_max_to_scan, s_mb_max_to_scan);
@@ -2263,6 +2288,10 @@ static struct attribute *ext4_attrs[] = {
 	ATTR_LIST(session_write_kbytes),
 	ATTR_LIST(lifetime_write_kbytes),
 	ATTR_LIST(inode_readahead_blks),
+	ATTR_LIST(readdir_prefetch),
+	ATTR_LIST(readdir_prefetch_inodes),
+	ATTR_LIST(readdir_prefetch_blocks),
+	ATTR_LIST(readdir_prefetch_hits),
 	ATTR_LIST(inode_goal),
 	ATTR_LIST(mb_stats),
 	ATTR_LIST(mb_max_to_scan),
@@ -255,6 +255,7 @@ void address_space_init_once(struct address_space *mapping)
 	spin_lock_init(&mapping->tree_lock);
 	mutex_init(&mapping->i_mmap_mutex);
 	INIT_LIST_HEAD(&mapping->private_list);
+	INIT_LIST_HEAD(&mapping->shadow_list);
 	spin_lock_init(&mapping->private_lock);
 	INIT_RAW_PRIO_TREE_ROOT(&mapping->i_mmap);
 	INIT_LIST_HEAD(&mapping->i_mmap_nonlinear);
@@ -368,6 +369,10 @@ EXPORT_SYMBOL(__remove_inode_hash);
 void end_writeback(struct inode *inode)
 {
 	might_sleep();
+	/* filesystems only truncate when there are pages left */
+	if (inode->i_data.nrshadows)
+		truncate_inode_pages(&inode->i_data, 0);
+	workingset_forget_mapping(&inode->i_data);
 	spin_lock_irq(&inode->i_data.tree_lock);
 	BUG_ON(inode->i_data.nrpages);
 	spin_unlock_irq(&inode->i_data.tree_lock);
@@ -56,6 +56,16 @@ void task_mem(struct seq_file *m, struct mm_struct *mm)
 		mm->stack_vm << (PAGE_SHIFT-10), text, lib,
 		(PTRS_PER_PTE*sizeof(pte_t)*mm->nr_ptes) >> 10,
 		swap << (PAGE_SHIFT-10));
+#ifdef CONFIG_SPECULATIVE_PAGE_FAULT
+	seq_printf(m,
+		"SpfSuccess:\t%lu\n"
+		"SpfFallback:\t%lu\n"
+		"MmapSemWait:\t%llu us\n",
+		atomic_long_read(&mm->spf_success),
+		atomic_long_read(&mm->spf_fallback),
+		(unsigned long long)atomic64_read(&mm->mmap_sem_wait_ns) /
+		NSEC_PER_USEC);
+#endif
 }
 
 unsigned long task_vsize(struct mm_struct *mm)
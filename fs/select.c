@@ -53,7 +53,7 @@ long select_estimate_accuracy(struct timespec *tv)
 	ktime_get_ts(&now);
 	now = timespec_sub(*tv, now);
 	return max_t(long, __estimate_accuracy(&now),
-			task_get_effective_timer_slack(current));
+			task_get_sleep_slack(current, timespec_to_ns(&now)));
 }
 
 
@@ -192,6 +192,9 @@ int poll_schedule_timeout(struct poll_wqueues *pwq, int state,
 		rc = freezable_schedule_hrtimeout_range(expires, slack,
 							HRTIMER_MODE_ABS);
 	__set_current_state(TASK_RUNNING);
+	if (!rc)
+		task_sleep_expired(current, ktime_add_ns(*expires, slack),
+				   ktime_get());
 
 	/*
 	 * Prepare for the next iteration.
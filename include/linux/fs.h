@@ -464,6 +464,9 @@ struct address_space {
 	struct mutex		i_mmap_mutex;	
 	
 	unsigned long		nrpages;	
+	unsigned long		nrshadows;	/* shadow entries of evicted pages */
+	struct list_head	shadow_list;	/* mappings holding shadows */
+	pgoff_t			shadow_index;	/* where shadow reclaim resumes */
 	pgoff_t			writeback_index;
 	const struct address_space_operations *a_ops;	
 	unsigned long		flags;		
@@ -291,6 +291,9 @@ void *alloc_pages_exact_nid(int nid, size_t size, gfp_t gfp_mask);
 		__get_free_pages((gfp_mask) | GFP_DMA, (order))
 
 extern void __free_pages(struct page *page, unsigned int order);
+extern unsigned int alloc_pages_bulk(gfp_t gfp_mask, unsigned int nr_pages,
+				     struct page **pages);
+extern void free_pages_bulk(struct page **pages, unsigned int nr_pages);
 extern void free_pages(unsigned long addr, unsigned int order);
 extern void free_hot_cold_page(struct page *page, int cold);
 extern void free_hot_cold_page_list(struct list_head *list, int cold);
@@ -125,6 +125,19 @@ extern bool initcall_debug;
 #define late_initcall(fn)		__define_initcall("7",fn,7)
 #define late_initcall_sync(fn)		__define_initcall("7s",fn,7s)
 
+#ifdef CONFIG_ASYNC_INITCALLS
+extern int __async_initcall(initcall_t fn);
+
+#define __define_async_initcall(level,fn,id) \
+	static int __init __async_initcall_##fn(void) \
+	{ return __async_initcall(fn); } \
+	__define_initcall(level,__async_initcall_##fn,id)
+
+#define device_initcall_async(fn)	__define_async_initcall("6",fn,6)
+#else
+#define device_initcall_async(fn)	device_initcall(fn)
+#endif
+
 #define __initcall(fn) device_initcall(fn)
 
 #define __exitcall(fn) \
@@ -164,6 +177,8 @@ void __init parse_early_options(char *cmdline);
 
 #define module_init(x)	__initcall(x);
 
+#define module_init_async(x)	device_initcall_async(x);
+
 #define module_exit(x)	__exitcall(x);
 
 #else 
@@ -175,6 +190,7 @@ void __init parse_early_options(char *cmdline);
 #define subsys_initcall(fn)		module_init(fn)
 #define fs_initcall(fn)			module_init(fn)
 #define device_initcall(fn)		module_init(fn)
+#define device_initcall_async(fn)	module_init(fn)
 #define late_initcall(fn)		module_init(fn)
 
 #define security_initcall(fn)		module_init(fn)
@@ -184,6 +200,8 @@ void __init parse_early_options(char *cmdline);
 	{ return initfn; }					\
 	int init_module(void) __attribute__((alias(#initfn)));
 
+#define module_init_async(initfn)	module_init(initfn)
+
 #define module_exit(exitfn)					\
 	static inline exitcall_t __exittest(void)		\
 	{ return exitfn; }					\
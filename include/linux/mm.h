@@ -36,6 +36,7 @@ extern unsigned long total_unmovable_pages;
 #endif
 extern void * high_memory;
 extern int page_cluster;
+extern int sysctl_lazy_fork_min_kbytes;
 
 #ifdef CONFIG_SYSCTL
 extern int sysctl_legacy_va_layout;
@@ -755,6 +756,63 @@ static inline int fixup_user_fault(struct task_struct *tsk,
 }
 #endif
 
+#ifdef CONFIG_SPECULATIVE_PAGE_FAULT
+extern int sysctl_speculative_page_fault;
+extern int handle_speculative_fault(struct mm_struct *mm,
+			unsigned long address, unsigned int flags,
+			unsigned long vm_mask);
+extern void spf_sync(struct mm_struct *mm);
+extern void fault_down_read_mmap_sem(struct mm_struct *mm);
+
+/*
+ * Writers holding mmap_sem for write bracket changes to a vma's range,
+ * flags or protection, and to the vma tree, so that speculative faults
+ * racing with them back off.
+ */
+static inline void vm_write_begin(struct vm_area_struct *vma)
+{
+	write_seqcount_begin(&vma->vm_sequence);
+}
+
+static inline void vm_write_end(struct vm_area_struct *vma)
+{
+	write_seqcount_end(&vma->vm_sequence);
+}
+
+/*
+ * These nest, so that a caller such as move_vma() can keep speculative
+ * faults out of the whole mm across vma changes that bracket the tree
+ * updates themselves.
+ */
+static inline void mm_rb_write_begin(struct mm_struct *mm)
+{
+	if (!mm->mm_rb_writers++)
+		write_seqcount_begin(&mm->mm_rb_seq);
+}
+
+static inline void mm_rb_write_end(struct mm_struct *mm)
+{
+	if (!--mm->mm_rb_writers)
+		write_seqcount_end(&mm->mm_rb_seq);
+}
+#else
+static inline int handle_speculative_fault(struct mm_struct *mm,
+			unsigned long address, unsigned int flags,
+			unsigned long vm_mask)
+{
+	return VM_FAULT_RETRY;
+}
+static inline void spf_sync(struct mm_struct *mm) {}
+static inline void fault_down_read_mmap_sem(struct mm_struct *mm)
+{
+	down_read(&mm->mmap_sem);
+}
+static inline void vm_write_begin(struct vm_area_struct *vma) {}
+static inline void vm_write_end(struct vm_area_struct *vma) {}
+static inline void mm_rb_write_begin(struct mm_struct *mm) {}
+static inline void mm_rb_write_end(struct mm_struct *mm) {}
+#endif
+
 extern int make_pages_present(unsigned long addr, unsigned long end);
 extern int access_process_vm(struct task_struct *tsk, unsigned long addr, void *buf, int len, int write);
 extern int access_remote_vm(struct mm_struct *mm, unsigned long addr,
@@ -1036,6 +1094,14 @@ extern int __meminit __early_pfn_to_nid(unsigned long pfn);
 #endif
 
 extern void set_dma_reserve(unsigned long new_dma_reserve);
+#ifdef CONFIG_DEFERRED_STRUCT_PAGE_INIT
+extern unsigned long deferred_init_pfn(void);
+#else
+static inline unsigned long deferred_init_pfn(void)
+{
+	return ULONG_MAX;
+}
+#endif
 extern void memmap_init_zone(unsigned long, int, unsigned long,
 				unsigned long, enum memmap_context);
 extern void setup_per_zone_wmarks(void);
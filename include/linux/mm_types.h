@@ -9,6 +9,7 @@
 #include <linux/prio_tree.h>
 #include <linux/rbtree.h>
 #include <linux/rwsem.h>
+#include <linux/seqlock.h>
 #include <linux/completion.h>
 #include <linux/cpumask.h>
 #include <linux/page-debug-flags.h>
@@ -167,6 +168,9 @@ struct vm_area_struct {
 #ifdef CONFIG_NUMA
 	struct mempolicy *vm_policy;	
 #endif
+#ifdef CONFIG_SPECULATIVE_PAGE_FAULT
+	seqcount_t vm_sequence;		/* bumped around changes of the above */
+#endif
 };
 
 struct core_thread {
@@ -220,6 +224,14 @@ struct mm_struct {
 
 	spinlock_t page_table_lock;		
 	struct rw_semaphore mmap_sem;
+#ifdef CONFIG_SPECULATIVE_PAGE_FAULT
+	seqcount_t mm_rb_seq;			/* bumped around mm_rb changes */
+	int mm_rb_writers;			/* nesting of mm_rb_write_begin() */
+	atomic_t spf_readers;			/* speculative faults in progress */
+	atomic_long_t spf_success;
+	atomic_long_t spf_fallback;
+	atomic64_t mmap_sem_wait_ns;		/* faults waiting for mmap_sem */
+#endif
 
 	struct list_head mmlist;		
 
@@ -106,6 +106,8 @@ enum zone_stat_item {
 	NR_SHMEM,		
 	NR_DIRTIED,		
 	NR_WRITTEN,		
+	WORKINGSET_REFAULT,
+	WORKINGSET_ACTIVATE,
 #ifdef CONFIG_NUMA
 	NUMA_HIT,		
 	NUMA_MISS,		
@@ -234,6 +236,8 @@ enum zone_type {
 struct zone_reclaim_stat {
 	unsigned long		recent_rotated[2];
 	unsigned long		recent_scanned[2];
+	/* usecs spent bringing reclaimed anon/file pages back */
+	unsigned long		recent_cost[2];
 };
 
 struct zone {
@@ -256,6 +260,13 @@ struct zone {
 	struct per_cpu_pageset __percpu *pageset;
 	spinlock_t		lock;
 	int                     all_unreclaimable; /* All pages pinned */
+#ifdef CONFIG_ZONE_LOCK_STAT
+	/* hold times of ->lock in the page allocator, protected by it */
+	u64			lock_hold_start;
+	u64			lock_hold_total_ns;
+	u64			lock_hold_max_ns;
+	unsigned long		lock_hold_count;
+#endif
 #if defined CONFIG_COMPACTION || defined CONFIG_CMA
 	/* Set to true when the PG_migrate_skip bits should be cleared */
 	bool			compact_blockskip_flush;
@@ -292,6 +303,9 @@ struct zone {
 
 	struct zone_reclaim_stat reclaim_stat;
 
+	/* evictions and activations of file pages, see mm/workingset.c */
+	atomic_long_t		inactive_age;
+
 	unsigned long		pages_scanned;	   
 	unsigned long		flags;		   
 
@@ -14,12 +14,22 @@
 #ifndef __MSM_THERMAL_H
 #define __MSM_THERMAL_H
 
+#define MSM_THERMAL_MAX_CORES	4
+
 struct msm_thermal_data {
 	uint32_t sensor_id;
 	uint32_t poll_ms;
 	uint32_t limit_temp;
 	uint32_t temp_hysteresis;
 	uint32_t limit_freq;
+	/*
+	 * Per-core TSENS sensors. When core_sensor_count is zero the
+	 * driver falls back to the single-sensor limit_freq policy.
+	 */
+	uint32_t core_sensor_count;
+	uint32_t core_sensor_id[MSM_THERMAL_MAX_CORES];
+	/* degrees above limit_temp at which a throttled core is offlined */
+	uint32_t core_offline_temp;
 };
 
 #ifdef CONFIG_THERMAL_MONITOR
@@ -39,6 +39,11 @@ struct tsens_device {
 
 int32_t tsens_get_sensor_temp(int sensor_num, unsigned long *temp);
 int32_t tsens_get_temp(struct tsens_device *dev, unsigned long *temp);
+
+typedef void (*tsens_threshold_notify_t)(void *data);
+int tsens_set_upper_threshold(uint32_t sensor_mask, long temp,
+			tsens_threshold_notify_t notify, void *data);
+void tsens_clear_upper_threshold(void);
 int msm_tsens_early_init(struct tsens_platform_data *pdata);
 
 #endif 
@@ -197,6 +197,9 @@ struct dev_pm_info {
 	struct completion	completion;
 	struct wakeup_source	*wakeup;
 	bool			wakeup_path:1;
+	bool			resume_on_demand:1;
+	bool			resume_pending:1;
+	struct list_head	deferred_entry;
 #else
 	unsigned int		should_wakeup:1;
 #endif
@@ -275,6 +278,10 @@ extern void __suspend_report_result(const char *function, void *fn, int ret);
 
 extern int device_pm_wait_for_dev(struct device *sub, struct device *dev);
 
+extern void device_set_resume_on_demand(struct device *dev, bool enable);
+extern int device_resume_on_demand(struct device *dev);
+extern void dpm_resume_deferred_devices(void);
+
 extern int pm_generic_prepare(struct device *dev);
 extern int pm_generic_suspend_late(struct device *dev);
 extern int pm_generic_suspend_noirq(struct device *dev);
@@ -313,6 +320,14 @@ static inline int device_pm_wait_for_dev(struct device *a, struct device *b)
 	return 0;
 }
 
+static inline void device_set_resume_on_demand(struct device *dev,
+					       bool enable) {}
+static inline int device_resume_on_demand(struct device *dev)
+{
+	return 0;
+}
+static inline void dpm_resume_deferred_devices(void) {}
+
 #define pm_generic_prepare	NULL
 #define pm_generic_suspend	NULL
 #define pm_generic_resume	NULL
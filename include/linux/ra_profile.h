@@ -0,0 +1,46 @@
+#ifndef _LINUX_RA_PROFILE_H
+#define _LINUX_RA_PROFILE_H
+
+#include <linux/fs.h>
+
+#ifdef CONFIG_READAHEAD_PROFILE
+extern int ra_profile_recording;
+extern int ra_profile_replaying;
+
+extern void __ra_profile_record(struct address_space *mapping, pgoff_t index);
+extern void __ra_profile_replay(struct file *file);
+
+static inline void ra_profile_record(struct address_space *mapping,
+				     pgoff_t index)
+{
+	if (unlikely(ra_profile_recording))
+		__ra_profile_record(mapping, index);
+}
+
+static inline void ra_profile_replay(struct file *file)
+{
+	if (unlikely(ra_profile_replaying))
+		__ra_profile_replay(file);
+}
+
+static inline bool ra_profile_is_recording(void)
+{
+	return ra_profile_recording;
+}
+#else
+static inline void ra_profile_record(struct address_space *mapping,
+				     pgoff_t index)
+{
+}
+
+static inline void ra_profile_replay(struct file *file)
+{
+}
+
+static inline bool ra_profile_is_recording(void)
+{
+	return false;
+}
+#endif
+
+#endif /* _LINUX_RA_PROFILE_H */
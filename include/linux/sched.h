@@ -2236,6 +2236,8 @@ extern long sched_group_rt_runtime(struct task_group *tg);
 extern int sched_group_set_rt_period(struct task_group *tg,
 				      long rt_period_us);
 extern long sched_group_rt_period(struct task_group *tg);
+extern int sched_group_set_rt_guaranteed(struct task_group *tg,
+					 int guaranteed);
 extern int sched_rt_can_attach(struct task_group *tg, struct task_struct *tsk);
 #endif
 #endif
@@ -2322,12 +2324,23 @@ static inline unsigned long rlimit_max(unsigned int limit)
 
 #ifdef CONFIG_CGROUP_TIMER_SLACK
 extern unsigned long task_get_effective_timer_slack(struct task_struct *tsk);
+extern unsigned long task_get_sleep_slack(struct task_struct *tsk,
+					  s64 sleep_ns);
+extern void task_sleep_expired(struct task_struct *tsk, ktime_t hard_expires,
+			       ktime_t now);
 #else
 static inline unsigned long task_get_effective_timer_slack(
 		struct task_struct *tsk)
 {
 	return tsk->timer_slack_ns;
 }
+static inline unsigned long task_get_sleep_slack(struct task_struct *tsk,
+						 s64 sleep_ns)
+{
+	return tsk->timer_slack_ns;
+}
+static inline void task_sleep_expired(struct task_struct *tsk,
+				      ktime_t hard_expires, ktime_t now) { }
 #endif
 
 #endif 
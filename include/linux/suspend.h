@@ -60,6 +60,10 @@ struct suspend_stats {
 	int	failed_resume;
 	int	failed_resume_early;
 	int	failed_resume_noirq;
+	int	deferred_resume;
+	int	deferred_resume_on_demand;
+	int	deferred_resume_late;
+	int	deferred_suspend_skipped;
 #define	REC_FAILED_NUM	2
 	int	last_failed_dev;
 	char	failed_devs[REC_FAILED_NUM][40];
@@ -105,6 +105,13 @@ enum {
 	SWP_SCANNING	= (1 << 8),	
 };
 
+/* swapin readahead policy of a swap device */
+enum {
+	SWAP_RA_CLUSTER,	/* aligned cluster of swap slots */
+	SWAP_RA_NONE,		/* faulting page only */
+	SWAP_RA_VMA,		/* swapped neighbours in the faulting vma */
+};
+
 #define SWAP_CLUSTER_MAX 32
 #define COMPACT_CLUSTER_MAX SWAP_CLUSTER_MAX
 
@@ -137,6 +144,9 @@ struct swap_info_struct {
 	struct block_device *bdev;	
 	struct file *swap_file;		
 	unsigned int old_block_size;	
+	int ra_policy;			/* SWAP_RA_* */
+	atomic_long_t ra_pages;		/* pages read ahead */
+	atomic_long_t ra_hits;		/* ... and faulted on later */
 };
 
 struct swap_list_t {
@@ -147,6 +157,14 @@ struct swap_list_t {
 #define vm_swap_full() (nr_swap_pages*2 < total_swap_pages)
 
 extern unsigned long totalram_pages;
+/* linux/mm/workingset.c */
+void *workingset_eviction(struct address_space *mapping, struct page *page);
+bool workingset_refault(void *shadow);
+void workingset_activation(struct page *page);
+void workingset_shadow_added(struct address_space *mapping);
+void workingset_shadow_removed(void);
+void workingset_forget_mapping(struct address_space *mapping);
+
 extern unsigned long totalreserve_pages;
 extern unsigned long dirty_balance_reserve;
 extern unsigned int nr_free_buffer_pages(void);
@@ -160,6 +178,7 @@ extern void lru_cache_add_lru(struct page *, enum lru_list lru);
 extern void lru_add_page_tail(struct zone* zone,
 			      struct page *page, struct page *page_tail);
 extern void activate_page(struct page *);
+extern void lru_note_cost(struct page *page, int file, ktime_t start);
 extern void mark_page_accessed(struct page *);
 extern void lru_add_drain(void);
 extern void lru_add_drain_cpu(int cpu);
@@ -191,6 +210,7 @@ extern unsigned long mem_cgroup_shrink_node_zone(struct mem_cgroup *mem,
 						unsigned long *nr_scanned);
 extern unsigned long shrink_all_memory(unsigned long nr_pages);
 extern int vm_swappiness;
+extern int sysctl_reclaim_cost_balance;
 extern int remove_mapping(struct address_space *mapping, struct page *page);
 extern long vm_total_pages;
 
@@ -262,6 +282,8 @@ extern struct page *read_swap_cache_async(swp_entry_t, gfp_t,
 			struct vm_area_struct *vma, unsigned long addr);
 extern struct page *swapin_readahead(swp_entry_t, gfp_t,
 			struct vm_area_struct *vma, unsigned long addr);
+extern struct page *swapin_readahead_vma(swp_entry_t, gfp_t,
+			struct vm_area_struct *vma, unsigned long addr);
 
 extern long nr_swap_pages;
 extern long total_swap_pages;
@@ -272,6 +294,7 @@ extern int add_swap_count_continuation(swp_entry_t, gfp_t);
 extern void swap_shmem_alloc(swp_entry_t);
 extern int swap_duplicate(swp_entry_t);
 extern int swapcache_prepare(swp_entry_t);
+extern struct swap_info_struct *swp_swap_info(swp_entry_t);
 extern void swap_free(swp_entry_t);
 extern void swapcache_free(swp_entry_t, struct page *page);
 extern int free_swap_and_cache(swp_entry_t);
@@ -342,6 +365,13 @@ static inline struct page *swapin_readahead(swp_entry_t swp, gfp_t gfp_mask,
 	return NULL;
 }
 
+static inline struct page *swapin_readahead_vma(swp_entry_t swp,
+			gfp_t gfp_mask, struct vm_area_struct *vma,
+			unsigned long addr)
+{
+	return NULL;
+}
+
 static inline int swap_writepage(struct page *p, struct writeback_control *wbc)
 {
 	return 0;
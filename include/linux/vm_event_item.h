@@ -37,6 +37,9 @@ enum vm_event_item { PGPGIN, PGPGOUT, PSWPIN, PSWPOUT,
 		KSWAPD_LOW_WMARK_HIT_QUICKLY, KSWAPD_HIGH_WMARK_HIT_QUICKLY,
 		KSWAPD_SKIP_CONGESTION_WAIT,
 		PAGEOUTRUN, ALLOCSTALL, PGROTATED,
+		RECLAIM_COST_ANON, RECLAIM_COST_FILE,
+		REFAULT_DISTANCE_25, REFAULT_DISTANCE_50,
+		REFAULT_DISTANCE_100, REFAULT_DISTANCE_FAR,
 #ifdef CONFIG_MIGRATION
 		PGMIGRATE_SUCCESS, PGMIGRATE_FAIL,
 #endif
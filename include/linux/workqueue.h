@@ -206,9 +206,10 @@ enum {
 	WQ_MEM_RECLAIM		= 1 << 3, 
 	WQ_HIGHPRI		= 1 << 4, 
 	WQ_CPU_INTENSIVE	= 1 << 5, 
+	WQ_POWER_EFFICIENT	= 1 << 6, 
 
-	WQ_DRAINING		= 1 << 6, 
-	WQ_RESCUER		= 1 << 7, 
+	WQ_DRAINING		= 1 << 7, 
+	WQ_RESCUER		= 1 << 8, 
 
 	WQ_MAX_ACTIVE		= 512,	  
 	WQ_MAX_UNBOUND_PER_CPU	= 4,	  
@@ -224,6 +225,7 @@ extern struct workqueue_struct *system_nrt_wq;
 extern struct workqueue_struct *system_unbound_wq;
 extern struct workqueue_struct *system_freezable_wq;
 extern struct workqueue_struct *system_nrt_freezable_wq;
+extern struct workqueue_struct *system_power_efficient_wq;
 
 extern struct workqueue_struct *
 __alloc_workqueue_key(const char *fmt, unsigned int flags, int max_active,
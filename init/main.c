@@ -601,16 +601,152 @@ static int __init_or_module do_one_initcall_debug(initcall_t fn)
 	return ret;
 }
 
+#ifdef CONFIG_ASYNC_INITCALLS
+#define INITCALL_REPORT_TOP	16
+
+struct initcall_record {
+	initcall_t fn;
+	s64 usecs;
+	bool async;
+};
+
+static bool async_initcalls __initdata = true;
+static LIST_HEAD(initcall_async_domain);
+static DEFINE_SPINLOCK(initcall_report_lock);
+static struct initcall_record initcall_top[INITCALL_REPORT_TOP];
+static s64 initcall_sync_usecs;
+static s64 initcall_async_usecs;
+static s64 initcall_barrier_usecs;
+static unsigned int initcall_async_count;
+
+static int __init no_async_initcalls(char *str)
+{
+	async_initcalls = false;
+	return 1;
+}
+__setup("no_async_initcalls", no_async_initcalls);
+
+static void initcall_record(initcall_t fn, s64 usecs, bool async)
+{
+	unsigned long flags;
+	int i;
+
+	spin_lock_irqsave(&initcall_report_lock, flags);
+	if (async)
+		initcall_async_usecs += usecs;
+	else
+		initcall_sync_usecs += usecs;
+
+	for (i = INITCALL_REPORT_TOP - 1; i >= 0; i--) {
+		if (initcall_top[i].fn && initcall_top[i].usecs >= usecs)
+			break;
+		if (i < INITCALL_REPORT_TOP - 1)
+			initcall_top[i + 1] = initcall_top[i];
+	}
+	if (++i < INITCALL_REPORT_TOP) {
+		initcall_top[i].fn = fn;
+		initcall_top[i].usecs = usecs;
+		initcall_top[i].async = async;
+	}
+	spin_unlock_irqrestore(&initcall_report_lock, flags);
+}
+
+static void __init initcall_async_run(void *data, async_cookie_t cookie)
+{
+	initcall_t fn = data;
+	ktime_t calltime;
+	s64 usecs;
+	int ret;
+
+	if (initcall_debug)
+		printk(KERN_DEBUG "calling  %pF @ %i (async)\n", fn,
+		       task_pid_nr(current));
+	calltime = ktime_get();
+	ret = fn();
+	usecs = ktime_us_delta(ktime_get(), calltime);
+	if (initcall_debug || (ret && ret != -ENODEV))
+		printk(KERN_DEBUG "initcall %pF returned %d after %lld usecs "
+		       "(async)\n", fn, ret, usecs);
+	initcall_record(fn, usecs, true);
+}
+
+int __init __async_initcall(initcall_t fn)
+{
+	if (!async_initcalls)
+		return fn();
+
+	spin_lock_irq(&initcall_report_lock);
+	initcall_async_count++;
+	spin_unlock_irq(&initcall_report_lock);
+	async_schedule_domain(initcall_async_run, fn, &initcall_async_domain);
+	return 0;
+}
+
+static void __init initcall_async_barrier(void)
+{
+	ktime_t start = ktime_get();
+
+	async_synchronize_full_domain(&initcall_async_domain);
+	initcall_barrier_usecs += ktime_us_delta(ktime_get(), start);
+}
+
+/*
+ * The boot thread's critical path is the time it spent in synchronous
+ * initcalls plus the time it waited at the barrier for async ones; the
+ * async initcalls that finished while it was busy elsewhere are the
+ * time saved.
+ */
+static void __init initcall_report(void)
+{
+	int i;
+
+	pr_info("initcalls: %lld ms sync, %lld ms async in %u calls, "
+		"%lld ms barrier wait\n",
+		initcall_sync_usecs / USEC_PER_MSEC,
+		initcall_async_usecs / USEC_PER_MSEC, initcall_async_count,
+		initcall_barrier_usecs / USEC_PER_MSEC);
+	pr_info("initcalls: critical path %lld ms, %lld ms saved\n",
+		(initcall_sync_usecs + initcall_barrier_usecs) / USEC_PER_MSEC,
+		(initcall_async_usecs - initcall_barrier_usecs) / USEC_PER_MSEC);
+	for (i = 0; i < INITCALL_REPORT_TOP && initcall_top[i].fn; i++)
+		pr_info("initcalls: %8lld us %s%pF\n", initcall_top[i].usecs,
+			initcall_top[i].async ? "[async] " : "",
+			initcall_top[i].fn);
+}
+#else
+static inline void initcall_record(initcall_t fn, s64 usecs, bool async)
+{
+}
+
+static inline void initcall_async_barrier(void)
+{
+}
+
+static inline void initcall_report(void)
+{
+}
+#endif
+
 int __init_or_module do_one_initcall(initcall_t fn)
 {
 	int count = preempt_count();
+	ktime_t calltime = ktime_set(0, 0);
 	int ret;
 
+	if (IS_ENABLED(CONFIG_ASYNC_INITCALLS) &&
+	    system_state == SYSTEM_BOOTING)
+		calltime = ktime_get();
+
 	if (initcall_debug)
 		ret = do_one_initcall_debug(fn);
 	else
 		ret = fn();
 
+	if (IS_ENABLED(CONFIG_ASYNC_INITCALLS) &&
+	    system_state == SYSTEM_BOOTING)
+		initcall_record(fn, ktime_us_delta(ktime_get(), calltime),
+				false);
+
 	msgbuf[0] = 0;
 
 	if (ret && ret != -ENODEV && initcall_debug)
@@ -686,8 +822,13 @@ static void __init do_initcalls(void)
 {
 	int level;
 
-	for (level = 0; level < ARRAY_SIZE(initcall_levels) - 1; level++)
+	for (level = 0; level < ARRAY_SIZE(initcall_levels) - 1; level++) {
+		/* async device initcalls must be done before late ones */
+		if (level == 7)
+			initcall_async_barrier();
 		do_initcall_level(level);
+	}
+	initcall_report();
 }
 
 static void __init do_basic_setup(void)
@@ -17,11 +17,17 @@
 #include <linux/cgroup.h>
 #include <linux/slab.h>
 #include <linux/err.h>
+#include <linux/ktime.h>
+
+/* the longest a deferrable cgroup may push back a sleep's wakeup */
+#define TSLACK_DEFER_MAX_NS	NSEC_PER_SEC
 
 struct cgroup_subsys timer_slack_subsys;
 struct tslack_cgroup {
 	struct cgroup_subsys_state css;
 	unsigned long min_slack_ns;
+	bool deferrable;
+	atomic_long_t wakeups_saved;
 };
 
 static struct tslack_cgroup *cgroup_to_tslack(struct cgroup *cgroup)
@@ -45,8 +51,12 @@ static struct cgroup_subsys_state *tslack_create(struct cgroup *cgroup)
 
 		parent = cgroup_to_tslack(cgroup->parent);
 		tslack_cgroup->min_slack_ns = parent->min_slack_ns;
-	} else
+		tslack_cgroup->deferrable = parent->deferrable;
+	} else {
 		tslack_cgroup->min_slack_ns = 0UL;
+		tslack_cgroup->deferrable = false;
+	}
+	atomic_long_set(&tslack_cgroup->wakeups_saved, 0);
 
 	return &tslack_cgroup->css;
 }
@@ -84,6 +94,27 @@ static u64 tslack_read_effective(struct cgroup *cgroup, struct cftype *cft)
 	return min;
 }
 
+static u64 tslack_read_deferrable(struct cgroup *cgroup, struct cftype *cft)
+{
+	return cgroup_to_tslack(cgroup)->deferrable;
+}
+
+static int tslack_write_deferrable(struct cgroup *cgroup, struct cftype *cft,
+				   u64 val)
+{
+	if (val > 1)
+		return -EINVAL;
+
+	cgroup_to_tslack(cgroup)->deferrable = val;
+
+	return 0;
+}
+
+static u64 tslack_read_wakeups_saved(struct cgroup *cgroup, struct cftype *cft)
+{
+	return atomic_long_read(&cgroup_to_tslack(cgroup)->wakeups_saved);
+}
+
 static struct cftype files[] = {
 	{
 		.name = "min_slack_ns",
@@ -94,6 +125,15 @@ static struct cftype files[] = {
 		.name = "effective_slack_ns",
 		.read_u64 = tslack_read_effective,
 	},
+	{
+		.name = "deferrable",
+		.read_u64 = tslack_read_deferrable,
+		.write_u64 = tslack_write_deferrable,
+	},
+	{
+		.name = "wakeups_saved",
+		.read_u64 = tslack_read_wakeups_saved,
+	},
 };
 
 static int tslack_populate(struct cgroup_subsys *subsys, struct cgroup *cgroup)
@@ -138,3 +178,47 @@ unsigned long task_get_effective_timer_slack(struct task_struct *tsk)
 
 	return max(tsk->timer_slack_ns, slack);
 }
+
+/*
+ * Slack for a select, poll, epoll_wait or nanosleep timeout @sleep_ns
+ * away. In a deferrable cgroup the wakeup may come up to the length of
+ * the sleep itself later, at most TSLACK_DEFER_MAX_NS, so that it can be
+ * served by an interrupt the CPU takes for something else.
+ */
+unsigned long task_get_sleep_slack(struct task_struct *tsk, s64 sleep_ns)
+{
+	unsigned long slack = task_get_effective_timer_slack(tsk);
+	bool deferrable;
+
+	rcu_read_lock();
+	deferrable = cgroup_to_tslack(task_cgroup(tsk,
+				timer_slack_subsys.subsys_id))->deferrable;
+	rcu_read_unlock();
+
+	if (deferrable && sleep_ns > 0)
+		slack = max_t(unsigned long, slack,
+			      min_t(s64, sleep_ns, TSLACK_DEFER_MAX_NS));
+
+	return slack;
+}
+
+/*
+ * A sleep timed out at @now. If that was before its hard expiry, the
+ * timer ran from an interrupt programmed for another event and the sleep
+ * cost no wakeup of its own.
+ */
+void task_sleep_expired(struct task_struct *tsk, ktime_t hard_expires,
+			ktime_t now)
+{
+	struct tslack_cgroup *tslack;
+
+	if (ktime_to_ns(ktime_sub(hard_expires, now)) <= 0)
+		return;
+
+	rcu_read_lock();
+	tslack = cgroup_to_tslack(task_cgroup(tsk,
+				timer_slack_subsys.subsys_id));
+	if (tslack->deferrable)
+		atomic_long_inc(&tslack->wakeups_saved);
+	rcu_read_unlock();
+}
@@ -472,6 +472,14 @@ static struct mm_struct *mm_init(struct mm_struct *mm, struct task_struct *p)
 	mm->nr_ptes = 0;
 	memset(&mm->rss_stat, 0, sizeof(mm->rss_stat));
 	spin_lock_init(&mm->page_table_lock);
+#ifdef CONFIG_SPECULATIVE_PAGE_FAULT
+	seqcount_init(&mm->mm_rb_seq);
+	mm->mm_rb_writers = 0;
+	atomic_set(&mm->spf_readers, 0);
+	atomic_long_set(&mm->spf_success, 0);
+	atomic_long_set(&mm->spf_fallback, 0);
+	atomic64_set(&mm->mmap_sem_wait_ns, 0);
+#endif
 	mm->free_area_cache = TASK_UNMAPPED_BASE;
 	mm->cached_hole_size = ~0UL;
 	mm_init_aio(mm);
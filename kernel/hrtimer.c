@@ -1184,16 +1184,23 @@ long hrtimer_nanosleep(struct timespec *rqtp, struct timespec __user *rmtp,
 	struct restart_block *restart;
 	struct hrtimer_sleeper t;
 	int ret = 0;
-	unsigned long slack;
-
-	slack = task_get_effective_timer_slack(current);
-	if (rt_task(current))
-		slack = 0;
+	unsigned long slack = 0;
+	ktime_t sleep;
 
 	hrtimer_init_on_stack(&t.timer, clockid, mode);
+
+	sleep = timespec_to_ktime(*rqtp);
+	if (mode == HRTIMER_MODE_ABS)
+		sleep = ktime_sub(sleep, t.timer.base->get_time());
+	if (!rt_task(current))
+		slack = task_get_sleep_slack(current, ktime_to_ns(sleep));
+
 	hrtimer_set_expires_range_ns(&t.timer, timespec_to_ktime(*rqtp), slack);
-	if (do_nanosleep(&t, mode))
+	if (do_nanosleep(&t, mode)) {
+		task_sleep_expired(current, hrtimer_get_expires(&t.timer),
+				   t.timer.base->get_time());
 		goto out;
+	}
 
 	
 	if (mode == HRTIMER_MODE_ABS) {
@@ -248,6 +248,7 @@ static void late_resume(struct work_struct *work)
 	}
 
 	boost_cpu_speed(1);
+	dpm_resume_deferred_devices();
 	init_timer_on_stack(&timer);
 	timer.function = early_suspend_handlers_timeout;
 
@@ -83,6 +83,32 @@ static ssize_t pm_async_store(struct kobject *kobj, struct kobj_attribute *attr,
 
 power_attr(pm_async);
 
+int pm_resume_on_demand_enabled = 1;
+
+static ssize_t pm_resume_on_demand_show(struct kobject *kobj,
+					struct kobj_attribute *attr, char *buf)
+{
+	return sprintf(buf, "%d\n", pm_resume_on_demand_enabled);
+}
+
+static ssize_t pm_resume_on_demand_store(struct kobject *kobj,
+					 struct kobj_attribute *attr,
+					 const char *buf, size_t n)
+{
+	unsigned long val;
+
+	if (strict_strtoul(buf, 10, &val))
+		return -EINVAL;
+
+	if (val > 1)
+		return -EINVAL;
+
+	pm_resume_on_demand_enabled = val;
+	return n;
+}
+
+power_attr(pm_resume_on_demand);
+
 static ssize_t
 touch_event_show(struct kobject *kobj,
 		 struct kobj_attribute *attr, char *buf)
@@ -265,6 +291,14 @@ static int suspend_stats_show(struct seq_file *s, void *unused)
 				suspend_stats.failed_resume_early,
 			"failed_resume_noirq",
 				suspend_stats.failed_resume_noirq);
+	seq_printf(s, "%s: %d\n%s: %d\n%s: %d\n%s: %d\n",
+			"deferred_resume", suspend_stats.deferred_resume,
+			"deferred_resume_on_demand",
+				suspend_stats.deferred_resume_on_demand,
+			"deferred_resume_late",
+				suspend_stats.deferred_resume_late,
+			"deferred_suspend_skipped",
+				suspend_stats.deferred_suspend_skipped);
 	seq_printf(s,	"failures:\n  last_failed_dev:\t%-s\n",
 			suspend_stats.failed_devs[last_dev]);
 	for (i = 1; i < REC_FAILED_NUM; i++) {
@@ -810,6 +844,7 @@ static struct attribute *g[] = {
 #endif
 #ifdef CONFIG_PM_SLEEP
 	&pm_async_attr.attr,
+	&pm_resume_on_demand_attr.attr,
 	&wakeup_count_attr.attr,
 	&touch_event_attr.attr,
 	&touch_event_timer_attr.attr,
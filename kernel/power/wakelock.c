@@ -44,7 +44,14 @@ module_param_named(debug_mask, debug_mask, int, S_IRUGO | S_IWUSR | S_IWGRP);
 
 static DEFINE_SPINLOCK(list_lock);
 static LIST_HEAD(inactive_locks);
+/*
+ * Active locks without a timeout live on active_wake_locks, so "is any
+ * such lock held" is a list_empty() check. Auto-expire locks live on
+ * active_expire_locks sorted by expiry: expired locks are reaped from the
+ * head and the last one to expire is at the tail.
+ */
 static struct list_head active_wake_locks[WAKE_LOCK_TYPE_COUNT];
+static struct list_head active_expire_locks[WAKE_LOCK_TYPE_COUNT];
 static int current_event_num;
 static int suspend_sys_sync_count;
 static DEFINE_SPINLOCK(suspend_sys_sync_lock);
@@ -143,60 +150,82 @@ static int wakelock_stats_show(struct seq_file *m, void *unused)
 	for (type = 0; type < WAKE_LOCK_TYPE_COUNT; type++) {
 		list_for_each_entry(lock, &active_wake_locks[type], link)
 			ret = print_lock_stat(m, lock);
+		list_for_each_entry(lock, &active_expire_locks[type], link)
+			ret = print_lock_stat(m, lock);
 	}
 	spin_unlock_irqrestore(&list_lock, irqflags);
 	return 0;
 }
 
-static void wake_unlock_stat_locked(struct wake_lock *lock, int expired)
+/*
+ * The stat helpers take a timestamp sampled by the caller before list_lock
+ * is acquired, so only the bookkeeping itself runs under the lock. Racing
+ * callers may sample slightly out of order; negative durations are
+ * clamped to zero.
+ */
+static void wake_unlock_stat_locked(struct wake_lock *lock, int expired,
+				    ktime_t now)
 {
 	ktime_t duration;
-	ktime_t now;
+	ktime_t end;
 	if (!(lock->flags & WAKE_LOCK_ACTIVE))
 		return;
-	if (get_expired_time(lock, &now))
+	if (get_expired_time(lock, &end))
 		expired = 1;
 	else
-		now = ktime_get();
+		end = now;
 	lock->stat.count++;
 	if (expired)
 		lock->stat.expire_count++;
-	duration = ktime_sub(now, lock->stat.last_time);
+	duration = ktime_sub(end, lock->stat.last_time);
+	if (duration.tv64 < 0)
+		duration = ktime_set(0, 0);
 	lock->stat.total_time = ktime_add(lock->stat.total_time, duration);
 	if (ktime_to_ns(duration) > ktime_to_ns(lock->stat.max_time))
 		lock->stat.max_time = duration;
-	lock->stat.last_time = ktime_get();
+	lock->stat.last_time = now;
 	if (lock->flags & WAKE_LOCK_PREVENTING_SUSPEND) {
-		duration = ktime_sub(now, last_sleep_time_update);
-		lock->stat.prevent_suspend_time = ktime_add(
-			lock->stat.prevent_suspend_time, duration);
+		duration = ktime_sub(end, last_sleep_time_update);
+		if (duration.tv64 > 0)
+			lock->stat.prevent_suspend_time = ktime_add(
+				lock->stat.prevent_suspend_time, duration);
 		lock->flags &= ~WAKE_LOCK_PREVENTING_SUSPEND;
 	}
 }
 
-static void update_sleep_wait_stats_locked(int done)
+static void update_sleep_wait_stats_lock(struct wake_lock *lock, int done,
+					 ktime_t elapsed)
 {
-	struct wake_lock *lock;
-	ktime_t now, etime, elapsed, add;
+	ktime_t etime, add;
 	int expired;
 
-	now = ktime_get();
-	elapsed = ktime_sub(now, last_sleep_time_update);
-	list_for_each_entry(lock, &active_wake_locks[WAKE_LOCK_SUSPEND], link) {
-		expired = get_expired_time(lock, &etime);
-		if (lock->flags & WAKE_LOCK_PREVENTING_SUSPEND) {
-			if (expired)
-				add = ktime_sub(etime, last_sleep_time_update);
-			else
-				add = elapsed;
+	expired = get_expired_time(lock, &etime);
+	if (lock->flags & WAKE_LOCK_PREVENTING_SUSPEND) {
+		if (expired)
+			add = ktime_sub(etime, last_sleep_time_update);
+		else
+			add = elapsed;
+		if (add.tv64 > 0)
 			lock->stat.prevent_suspend_time = ktime_add(
 				lock->stat.prevent_suspend_time, add);
-		}
-		if (done || expired)
-			lock->flags &= ~WAKE_LOCK_PREVENTING_SUSPEND;
-		else
-			lock->flags |= WAKE_LOCK_PREVENTING_SUSPEND;
 	}
+	if (done || expired)
+		lock->flags &= ~WAKE_LOCK_PREVENTING_SUSPEND;
+	else
+		lock->flags |= WAKE_LOCK_PREVENTING_SUSPEND;
+}
+
+static void update_sleep_wait_stats_locked(int done, ktime_t now)
+{
+	struct wake_lock *lock;
+	ktime_t elapsed;
+
+	elapsed = ktime_sub(now, last_sleep_time_update);
+	list_for_each_entry(lock, &active_wake_locks[WAKE_LOCK_SUSPEND], link)
+		update_sleep_wait_stats_lock(lock, done, elapsed);
+	list_for_each_entry(lock, &active_expire_locks[WAKE_LOCK_SUSPEND],
+			    link)
+		update_sleep_wait_stats_lock(lock, done, elapsed);
 	last_sleep_time_update = now;
 }
 #endif
@@ -205,7 +234,7 @@ static void update_sleep_wait_stats_locked(int done)
 static void expire_wake_lock(struct wake_lock *lock)
 {
 #ifdef CONFIG_WAKELOCK_STAT
-	wake_unlock_stat_locked(lock, 1);
+	wake_unlock_stat_locked(lock, 1, ktime_get());
 #endif
 	lock->flags &= ~(WAKE_LOCK_ACTIVE | WAKE_LOCK_AUTO_EXPIRE);
 	list_del(&lock->link);
@@ -221,18 +250,17 @@ static void print_active_locks(int type)
 
 	BUG_ON(type >= WAKE_LOCK_TYPE_COUNT);
 	list_for_each_entry(lock, &active_wake_locks[type], link) {
-		if (lock->flags & WAKE_LOCK_AUTO_EXPIRE) {
-			long timeout = lock->expires - jiffies;
-			if (timeout > 0)
-				pr_info("active wake lock %s, time left %ld\n",
-					lock->name, timeout);
-			else if (print_expired)
-				pr_info("wake lock %s, expired\n", lock->name);
-		} else {
-			pr_info("active wake lock %s\n", lock->name);
-			if (!(debug_mask & DEBUG_EXPIRE))
-				print_expired = false;
-		}
+		pr_info("active wake lock %s\n", lock->name);
+		if (!(debug_mask & DEBUG_EXPIRE))
+			print_expired = false;
+	}
+	list_for_each_entry(lock, &active_expire_locks[type], link) {
+		long timeout = lock->expires - jiffies;
+		if (timeout > 0)
+			pr_info("active wake lock %s, time left %ld\n",
+				lock->name, timeout);
+		else if (print_expired)
+			pr_info("wake lock %s, expired\n", lock->name);
 	}
 }
 
@@ -241,45 +269,57 @@ void htc_print_active_wake_locks(int type)
 	struct wake_lock *lock;
 	unsigned long irqflags;
 	spin_lock_irqsave(&list_lock, irqflags);
-	if((!list_empty(&active_wake_locks[type]))){
+	if (!list_empty(&active_wake_locks[type]) ||
+	    !list_empty(&active_expire_locks[type])) {
 #if 0 
 		if(type==WAKE_LOCK_IDLE)
 			printk("idle lock: ");
 		else
 #endif
 		printk("wakelock: ");
-		list_for_each_entry(lock, &active_wake_locks[type], link) {
-			if (lock->flags & WAKE_LOCK_AUTO_EXPIRE) {
-				long timeout = lock->expires - jiffies;
-				if (timeout > 0)
-					printk(" '%s', time left %ld; ",
-						lock->name, timeout);
-			} else {
-				printk(" '%s' ", lock->name);
-			}
+		list_for_each_entry(lock, &active_wake_locks[type], link)
+			printk(" '%s' ", lock->name);
+		list_for_each_entry(lock, &active_expire_locks[type], link) {
+			long timeout = lock->expires - jiffies;
+			if (timeout > 0)
+				printk(" '%s', time left %ld; ",
+					lock->name, timeout);
 		}
 		printk("\n");
 	}
 	spin_unlock_irqrestore(&list_lock, irqflags);
 }
 
+static void add_expire_lock_locked(struct wake_lock *lock, int type)
+{
+	struct list_head *pos;
+	struct wake_lock *prev;
+
+	list_for_each_prev(pos, &active_expire_locks[type]) {
+		prev = list_entry(pos, struct wake_lock, link);
+		if ((long)(prev->expires - lock->expires) <= 0)
+			break;
+	}
+	list_add(&lock->link, pos);
+}
+
 static long has_wake_lock_locked(int type)
 {
 	struct wake_lock *lock, *n;
-	long max_timeout = 0;
+	struct list_head *expire_locks = &active_expire_locks[type];
 
 	BUG_ON(type >= WAKE_LOCK_TYPE_COUNT);
-	list_for_each_entry_safe(lock, n, &active_wake_locks[type], link) {
-		if (lock->flags & WAKE_LOCK_AUTO_EXPIRE) {
-			long timeout = lock->expires - jiffies;
-			if (timeout <= 0)
-				expire_wake_lock(lock);
-			else if (timeout > max_timeout)
-				max_timeout = timeout;
-		} else
-			return -1;
+	list_for_each_entry_safe(lock, n, expire_locks, link) {
+		if ((long)(lock->expires - jiffies) > 0)
+			break;
+		expire_wake_lock(lock);
 	}
-	return max_timeout;
+	if (!list_empty(&active_wake_locks[type]))
+		return -1;
+	if (list_empty(expire_locks))
+		return 0;
+	lock = list_entry(expire_locks->prev, struct wake_lock, link);
+	return lock->expires - jiffies;
 }
 
 long has_wake_lock(int type)
@@ -506,6 +546,9 @@ static void wake_lock_internal(
 	int type;
 	unsigned long irqflags;
 	long expire_in;
+#ifdef CONFIG_WAKELOCK_STAT
+	ktime_t now = ktime_get();
+#endif
 
 	spin_lock_irqsave(&list_lock, irqflags);
 	type = lock->flags & WAKE_LOCK_TYPE_MASK;
@@ -519,15 +562,13 @@ static void wake_lock_internal(
 		lock->stat.wakeup_count++;
 	}
 	if ((lock->flags & WAKE_LOCK_AUTO_EXPIRE) &&
-	    (long)(lock->expires - jiffies) <= 0) {
-		wake_unlock_stat_locked(lock, 0);
-		lock->stat.last_time = ktime_get();
-	}
+	    (long)(lock->expires - jiffies) <= 0)
+		wake_unlock_stat_locked(lock, 0, now);
 #endif
 	if (!(lock->flags & WAKE_LOCK_ACTIVE)) {
 		lock->flags |= WAKE_LOCK_ACTIVE;
 #ifdef CONFIG_WAKELOCK_STAT
-		lock->stat.last_time = ktime_get();
+		lock->stat.last_time = now;
 #endif
 	}
 	list_del(&lock->link);
@@ -538,7 +579,7 @@ static void wake_lock_internal(
 				(timeout % HZ) * MSEC_PER_SEC / HZ);
 		lock->expires = jiffies + timeout;
 		lock->flags |= WAKE_LOCK_AUTO_EXPIRE;
-		list_add_tail(&lock->link, &active_wake_locks[type]);
+		add_expire_lock_locked(lock, type);
 	} else {
 		if (debug_mask & DEBUG_WAKE_LOCK)
 			pr_info("wake_lock: %s, type %d\n", lock->name, type);
@@ -550,9 +591,9 @@ static void wake_lock_internal(
 		current_event_num++;
 #ifdef CONFIG_WAKELOCK_STAT
 		if (lock == &main_wake_lock)
-			update_sleep_wait_stats_locked(1);
+			update_sleep_wait_stats_locked(1, now);
 		else if (!wake_lock_active(&main_wake_lock))
-			update_sleep_wait_stats_locked(0);
+			update_sleep_wait_stats_locked(0, now);
 #endif
 		if (has_timeout)
 			expire_in = has_wake_lock_locked(type);
@@ -591,10 +632,13 @@ void wake_unlock(struct wake_lock *lock)
 {
 	int type;
 	unsigned long irqflags;
+#ifdef CONFIG_WAKELOCK_STAT
+	ktime_t now = ktime_get();
+#endif
 	spin_lock_irqsave(&list_lock, irqflags);
 	type = lock->flags & WAKE_LOCK_TYPE_MASK;
 #ifdef CONFIG_WAKELOCK_STAT
-	wake_unlock_stat_locked(lock, 0);
+	wake_unlock_stat_locked(lock, 0, now);
 #endif
 	if (debug_mask & DEBUG_WAKE_LOCK)
 		pr_info("wake_unlock: %s\n", lock->name);
@@ -620,7 +664,7 @@ void wake_unlock(struct wake_lock *lock)
 			if (debug_mask & DEBUG_SUSPEND)
 				print_active_locks(WAKE_LOCK_SUSPEND);
 #ifdef CONFIG_WAKELOCK_STAT
-			update_sleep_wait_stats_locked(0);
+			update_sleep_wait_stats_locked(0, now);
 #endif
 		}
 	}
@@ -655,8 +699,10 @@ static int __init wakelocks_init(void)
 	if (get_kernel_flag() & KERNEL_FLAG_WAKELOCK_DBG)
 		debug_mask |= DEBUG_WAKE_LOCK;
 
-	for (i = 0; i < ARRAY_SIZE(active_wake_locks); i++)
+	for (i = 0; i < ARRAY_SIZE(active_wake_locks); i++) {
 		INIT_LIST_HEAD(&active_wake_locks[i]);
+		INIT_LIST_HEAD(&active_expire_locks[i]);
+	}
 
 #ifdef CONFIG_WAKELOCK_STAT
 	wake_lock_init(&deleted_wake_locks, WAKE_LOCK_SUSPEND,
@@ -5925,6 +5925,48 @@ static int __rt_schedulable(struct task_group *tg, u64 period, u64 runtime)
 	return ret;
 }
 
+/*
+ * A group keeps back, for its guaranteed subgroups, the bandwidth of each
+ * guaranteed child plus whatever its other children keep back themselves,
+ * converted to its own period. Called with rt_constraints_mutex held after
+ * a change below or at @tg.
+ */
+static void tg_update_rt_reserved(struct task_group *tg)
+{
+	rcu_read_lock();
+	for (; tg; tg = tg->parent) {
+		struct task_group *child;
+		unsigned long ratio = 0;
+		u64 reserved;
+		int i;
+
+		list_for_each_entry_rcu(child, &tg->children, siblings) {
+			u64 runtime = child->rt_bandwidth.rt_runtime;
+
+			if (!child->rt_guaranteed)
+				ratio += child->rt_reserved_ratio;
+			else if (runtime != RUNTIME_INF)
+				ratio += to_ratio(ktime_to_ns(
+					child->rt_bandwidth.rt_period), runtime);
+		}
+		tg->rt_reserved_ratio = ratio;
+
+		reserved = ktime_to_ns(tg->rt_bandwidth.rt_period) * ratio;
+		reserved >>= 20;
+
+		raw_spin_lock_irq(&tg->rt_bandwidth.rt_runtime_lock);
+		for_each_possible_cpu(i) {
+			struct rt_rq *rt_rq = tg->rt_rq[i];
+
+			raw_spin_lock(&rt_rq->rt_runtime_lock);
+			rt_rq->rt_reserved = reserved;
+			raw_spin_unlock(&rt_rq->rt_runtime_lock);
+		}
+		raw_spin_unlock_irq(&tg->rt_bandwidth.rt_runtime_lock);
+	}
+	rcu_read_unlock();
+}
+
 static int tg_set_rt_bandwidth(struct task_group *tg,
 		u64 rt_period, u64 rt_runtime)
 {
@@ -5948,6 +5990,7 @@ static int tg_set_rt_bandwidth(struct task_group *tg,
 		raw_spin_unlock(&rt_rq->rt_runtime_lock);
 	}
 	raw_spin_unlock_irq(&tg->rt_bandwidth.rt_runtime_lock);
+	tg_update_rt_reserved(tg);
 unlock:
 	read_unlock(&tasklist_lock);
 	mutex_unlock(&rt_constraints_mutex);
@@ -6001,6 +6044,28 @@ long sched_group_rt_period(struct task_group *tg)
 	return rt_period_us;
 }
 
+int sched_group_set_rt_guaranteed(struct task_group *tg, int guaranteed)
+{
+	int err = 0;
+
+	if (tg == &root_task_group)
+		return -EINVAL;
+
+	mutex_lock(&rt_constraints_mutex);
+	if (guaranteed && !tg->rt_bandwidth.rt_runtime) {
+		err = -EINVAL;
+		goto unlock;
+	}
+	if (tg->rt_guaranteed != guaranteed) {
+		tg->rt_guaranteed = guaranteed;
+		set_rt_group_guaranteed(tg, guaranteed);
+		tg_update_rt_reserved(tg->parent);
+	}
+unlock:
+	mutex_unlock(&rt_constraints_mutex);
+	return err;
+}
+
 static int sched_rt_global_constraints(void)
 {
 	u64 runtime, period;
@@ -6117,8 +6182,17 @@ static struct cgroup_subsys_state *cpu_cgroup_create(struct cgroup *cgrp)
 static void cpu_cgroup_destroy(struct cgroup *cgrp)
 {
 	struct task_group *tg = cgroup_tg(cgrp);
+#ifdef CONFIG_RT_GROUP_SCHED
+	struct task_group *parent = tg->parent;
+#endif
 
 	sched_destroy_group(tg);
+
+#ifdef CONFIG_RT_GROUP_SCHED
+	mutex_lock(&rt_constraints_mutex);
+	tg_update_rt_reserved(parent);
+	mutex_unlock(&rt_constraints_mutex);
+#endif
 }
 
 static int
@@ -6443,6 +6517,38 @@ static u64 cpu_rt_period_read_uint(struct cgroup *cgrp, struct cftype *cft)
 {
 	return sched_group_rt_period(cgroup_tg(cgrp));
 }
+
+static int cpu_rt_guaranteed_write(struct cgroup *cgrp, struct cftype *cft,
+				   u64 val)
+{
+	if (val > 1)
+		return -EINVAL;
+
+	return sched_group_set_rt_guaranteed(cgroup_tg(cgrp), val);
+}
+
+static u64 cpu_rt_guaranteed_read(struct cgroup *cgrp, struct cftype *cft)
+{
+	return cgroup_tg(cgrp)->rt_guaranteed;
+}
+
+static int cpu_rt_stats_show(struct cgroup *cgrp, struct cftype *cft,
+		struct cgroup_map_cb *cb)
+{
+	struct task_group *tg = cgroup_tg(cgrp);
+	u64 nr_throttled = 0, throttled_time = 0;
+	int i;
+
+	for_each_possible_cpu(i) {
+		nr_throttled += tg->rt_rq[i]->rt_nr_throttled;
+		throttled_time += tg->rt_rq[i]->rt_throttled_time;
+	}
+
+	cb->fill(cb, "nr_throttled", nr_throttled);
+	cb->fill(cb, "throttled_time", throttled_time);
+
+	return 0;
+}
 #endif 
 
 static struct cftype cpu_files[] = {
@@ -6485,6 +6591,15 @@ static struct cftype cpu_files[] = {
 		.read_u64 = cpu_rt_period_read_uint,
 		.write_u64 = cpu_rt_period_write_uint,
 	},
+	{
+		.name = "rt_guaranteed",
+		.read_u64 = cpu_rt_guaranteed_read,
+		.write_u64 = cpu_rt_guaranteed_write,
+	},
+	{
+		.name = "rt_stat",
+		.read_map = cpu_rt_stats_show,
+	},
 #endif
 };
 
@@ -235,8 +235,11 @@ void print_rt_rq(struct seq_file *m, int cpu, struct rt_rq *rt_rq)
 
 	P(rt_nr_running);
 	P(rt_throttled);
+	P(rt_restricted);
 	PN(rt_time);
 	PN(rt_runtime);
+	P(rt_nr_throttled);
+	PN(rt_throttled_time);
 
 #undef PN
 #undef P
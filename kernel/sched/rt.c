@@ -76,7 +76,10 @@ void init_rt_rq(struct rt_rq *rt_rq, struct rq *rq)
 
 	rt_rq->rt_time = 0;
 	rt_rq->rt_throttled = 0;
+	rt_rq->rt_restricted = 0;
 	rt_rq->rt_runtime = 0;
+	rt_rq->rt_nr_throttled = 0;
+	rt_rq->rt_throttled_time = 0;
 	raw_spin_lock_init(&rt_rq->rt_runtime_lock);
 }
 
@@ -132,6 +135,10 @@ void init_tg_rt_entry(struct task_group *tg, struct rt_rq *rt_rq,
 
 	rt_rq->highest_prio.curr = MAX_RT_PRIO;
 	rt_rq->rt_nr_boosted = 0;
+	rt_rq->rt_nr_guaranteed = 0;
+	rt_rq->rt_guaranteed = 0;
+	rt_rq->rt_reserved = 0;
+	rt_rq->rt_guaranteed_time = 0;
 	rt_rq->rq = rq;
 	rt_rq->tg = tg;
 
@@ -433,9 +440,50 @@ static void sched_rt_rq_dequeue(struct rt_rq *rt_rq)
 		dequeue_rt_entity(rt_se);
 }
 
+/*
+ * An rt_rq whose time exceeds its runtime less what it reserves for
+ * guaranteed subgroups is restricted: only entities that are or contain
+ * a guaranteed group may run. Past its full runtime it is throttled.
+ * A restricted rt_rq without guaranteed entities queued is as good as
+ * throttled.
+ */
 static inline int rt_rq_throttled(struct rt_rq *rt_rq)
 {
-	return rt_rq->rt_throttled && !rt_rq->rt_nr_boosted;
+	if (rt_rq->rt_nr_boosted)
+		return 0;
+
+	return rt_rq->rt_throttled ||
+	       (rt_rq->rt_restricted && !rt_rq->rt_nr_guaranteed);
+}
+
+static inline int rt_rq_restricted(struct rt_rq *rt_rq)
+{
+	return rt_rq->rt_restricted && !rt_rq->rt_nr_boosted;
+}
+
+static inline int rt_rq_guaranteed(struct rt_rq *rt_rq)
+{
+	return rt_rq->rt_guaranteed;
+}
+
+/*
+ * The part of the reserve that guaranteed subgroups have not used yet this
+ * period. What they did use is in rt_time already.
+ */
+static inline u64 sched_rt_reserved(struct rt_rq *rt_rq)
+{
+	return rt_rq->rt_reserved -
+	       min(rt_rq->rt_reserved, rt_rq->rt_guaranteed_time);
+}
+
+static inline void sched_rt_charge_guaranteed(struct rt_rq *rt_rq, u64 delta)
+{
+	rt_rq->rt_guaranteed_time += delta;
+}
+
+static inline void sched_rt_clear_guaranteed(struct rt_rq *rt_rq)
+{
+	rt_rq->rt_guaranteed_time = 0;
 }
 
 static int rt_se_boosted(struct sched_rt_entity *rt_se)
@@ -450,6 +498,58 @@ static int rt_se_boosted(struct sched_rt_entity *rt_se)
 	return p->prio != p->normal_prio;
 }
 
+static int rt_se_guaranteed(struct sched_rt_entity *rt_se)
+{
+	struct rt_rq *rt_rq = group_rt_rq(rt_se);
+
+	return rt_rq && (rt_rq->rt_guaranteed || rt_rq->rt_nr_guaranteed);
+}
+
+/*
+ * Pick for a restricted rt_rq: the highest priority entity that is or
+ * contains a guaranteed group.
+ */
+static struct sched_rt_entity *pick_guaranteed_rt_entity(struct rt_rq *rt_rq)
+{
+	struct rt_prio_array *array = &rt_rq->active;
+	struct sched_rt_entity *rt_se;
+	int idx;
+
+	for (idx = sched_find_first_bit(array->bitmap); idx < MAX_RT_PRIO;
+	     idx = find_next_bit(array->bitmap, MAX_RT_PRIO, idx + 1)) {
+		list_for_each_entry(rt_se, array->queue + idx, run_list) {
+			if (rt_se_guaranteed(rt_se))
+				return rt_se;
+		}
+	}
+
+	return NULL;
+}
+
+/*
+ * The flag is part of the guaranteed accounting of the parent rt_rq, so
+ * it may only change while the group entity is dequeued.
+ */
+void set_rt_group_guaranteed(struct task_group *tg, int guaranteed)
+{
+	int i;
+
+	for_each_possible_cpu(i) {
+		struct rt_rq *rt_rq = tg->rt_rq[i];
+		struct rq *rq = rq_of_rt_rq(rt_rq);
+		int queued;
+
+		raw_spin_lock_irq(&rq->lock);
+		queued = on_rt_rq(tg->rt_se[i]);
+		if (queued)
+			sched_rt_rq_dequeue(rt_rq);
+		rt_rq->rt_guaranteed = guaranteed;
+		if (queued)
+			sched_rt_rq_enqueue(rt_rq);
+		raw_spin_unlock_irq(&rq->lock);
+	}
+}
+
 #ifdef CONFIG_SMP
 static inline const struct cpumask *sched_rt_period_mask(void)
 {
@@ -524,6 +624,35 @@ static inline int rt_rq_throttled(struct rt_rq *rt_rq)
 	return rt_rq->rt_throttled;
 }
 
+static inline int rt_rq_restricted(struct rt_rq *rt_rq)
+{
+	return 0;
+}
+
+static inline int rt_rq_guaranteed(struct rt_rq *rt_rq)
+{
+	return 0;
+}
+
+static inline u64 sched_rt_reserved(struct rt_rq *rt_rq)
+{
+	return 0;
+}
+
+static inline void sched_rt_charge_guaranteed(struct rt_rq *rt_rq, u64 delta)
+{
+}
+
+static inline void sched_rt_clear_guaranteed(struct rt_rq *rt_rq)
+{
+}
+
+static inline
+struct sched_rt_entity *pick_guaranteed_rt_entity(struct rt_rq *rt_rq)
+{
+	return NULL;
+}
+
 static inline const struct cpumask *sched_rt_period_mask(void)
 {
 	return cpu_online_mask;
@@ -542,6 +671,16 @@ static inline struct rt_bandwidth *sched_rt_bandwidth(struct rt_rq *rt_rq)
 
 #endif 
 
+/* Lift all throttling of @rt_rq, called with its rt_runtime_lock held */
+static void rt_rq_unthrottle(struct rt_rq *rt_rq)
+{
+	if (rt_rq->rt_restricted)
+		rt_rq->rt_throttled_time +=
+			rq_of_rt_rq(rt_rq)->clock - rt_rq->rt_throttled_clock;
+	rt_rq->rt_throttled = 0;
+	rt_rq->rt_restricted = 0;
+}
+
 #ifdef CONFIG_SMP
 static int do_balance_runtime(struct rt_rq *rt_rq)
 {
@@ -635,7 +774,7 @@ static void __disable_runtime(struct rq *rq)
 		BUG_ON(want);
 balanced:
 		rt_rq->rt_runtime = RUNTIME_INF;
-		rt_rq->rt_throttled = 0;
+		rt_rq_unthrottle(rt_rq);
 		raw_spin_unlock(&rt_rq->rt_runtime_lock);
 		raw_spin_unlock(&rt_b->rt_runtime_lock);
 	}
@@ -665,7 +804,8 @@ static void __enable_runtime(struct rq *rq)
 		raw_spin_lock(&rt_rq->rt_runtime_lock);
 		rt_rq->rt_runtime = rt_b->rt_runtime;
 		rt_rq->rt_time = 0;
-		rt_rq->rt_throttled = 0;
+		sched_rt_clear_guaranteed(rt_rq);
+		rt_rq_unthrottle(rt_rq);
 		raw_spin_unlock(&rt_rq->rt_runtime_lock);
 		raw_spin_unlock(&rt_b->rt_runtime_lock);
 	}
@@ -744,6 +884,7 @@ static int do_sched_rt_period_timer(struct rt_bandwidth *rt_b, int overrun)
 				balance_runtime(rt_rq);
 			runtime = rt_rq->rt_runtime;
 			rt_rq->rt_time -= min(rt_rq->rt_time, overrun*runtime);
+			sched_rt_clear_guaranteed(rt_rq);
 			if (rt_rq->rt_throttled && rt_rq->rt_time < runtime) {
 				rt_rq->rt_throttled = 0;
 				enqueue = 1;
@@ -751,6 +892,11 @@ static int do_sched_rt_period_timer(struct rt_bandwidth *rt_b, int overrun)
 				if (rt_rq->rt_nr_running && rq->curr == rq->idle)
 					rq->skip_clock_update = -1;
 			}
+			if (rt_rq->rt_restricted &&
+			    rt_rq->rt_time + sched_rt_reserved(rt_rq) < runtime) {
+				rt_rq_unthrottle(rt_rq);
+				enqueue = 1;
+			}
 			if (rt_rq->rt_time || rt_rq->rt_nr_running)
 				idle = 0;
 			raw_spin_unlock(&rt_rq->rt_runtime_lock);
@@ -759,7 +905,7 @@ static int do_sched_rt_period_timer(struct rt_bandwidth *rt_b, int overrun)
 			if (!rt_rq_throttled(rt_rq))
 				enqueue = 1;
 		}
-		if (rt_rq->rt_throttled)
+		if (rt_rq->rt_restricted)
 			throttled = 1;
 
 		if (enqueue)
@@ -788,6 +934,7 @@ static inline int rt_se_prio(struct sched_rt_entity *rt_se)
 static int sched_rt_runtime_exceeded(struct rt_rq *rt_rq)
 {
 	u64 runtime = sched_rt_runtime(rt_rq);
+	int restricted = rt_rq->rt_restricted;
 
 	if (rt_rq->rt_throttled)
 		return rt_rq_throttled(rt_rq);
@@ -800,13 +947,20 @@ static int sched_rt_runtime_exceeded(struct rt_rq *rt_rq)
 	if (runtime == RUNTIME_INF)
 		return 0;
 
-	if (rt_rq->rt_time > runtime) {
+	if (rt_rq->rt_time + sched_rt_reserved(rt_rq) > runtime) {
 		struct rt_bandwidth *rt_b = sched_rt_bandwidth(rt_rq);
 
 		if (likely(rt_b->rt_runtime)) {
 			static bool once = false;
 
-			rt_rq->rt_throttled = 1;
+			if (!restricted) {
+				rt_rq->rt_restricted = 1;
+				rt_rq->rt_nr_throttled++;
+				rt_rq->rt_throttled_clock =
+					rq_of_rt_rq(rt_rq)->clock;
+			}
+			if (rt_rq->rt_time > runtime)
+				rt_rq->rt_throttled = 1;
 
 			if (!once) {
 				once = true;
@@ -814,12 +968,16 @@ static int sched_rt_runtime_exceeded(struct rt_rq *rt_rq)
 			}
 		} else {
 			rt_rq->rt_time = 0;
+			sched_rt_clear_guaranteed(rt_rq);
 		}
 
 		if (rt_rq_throttled(rt_rq)) {
 			sched_rt_rq_dequeue(rt_rq);
 			return 1;
 		}
+
+		/* reschedule once so that the pick skips the others */
+		return !restricted && rt_rq_restricted(rt_rq);
 	}
 
 	return 0;
@@ -831,6 +989,7 @@ static void update_curr_rt(struct rq *rq)
 	struct sched_rt_entity *rt_se = &curr->rt;
 	struct rt_rq *rt_rq = rt_rq_of_se(rt_se);
 	u64 delta_exec;
+	int guaranteed = 0;
 
 	if (curr->sched_class != &rt_sched_class)
 		return;
@@ -859,10 +1018,14 @@ static void update_curr_rt(struct rq *rq)
 		if (sched_rt_runtime(rt_rq) != RUNTIME_INF) {
 			raw_spin_lock(&rt_rq->rt_runtime_lock);
 			rt_rq->rt_time += delta_exec;
+			if (guaranteed)
+				sched_rt_charge_guaranteed(rt_rq, delta_exec);
 			if (sched_rt_runtime_exceeded(rt_rq))
 				resched_task(curr);
 			raw_spin_unlock(&rt_rq->rt_runtime_lock);
 		}
+		/* the levels above reserve this time for us */
+		guaranteed |= rt_rq_guaranteed(rt_rq);
 	}
 }
 
@@ -943,6 +1106,8 @@ inc_rt_group(struct sched_rt_entity *rt_se, struct rt_rq *rt_rq)
 {
 	if (rt_se_boosted(rt_se))
 		rt_rq->rt_nr_boosted++;
+	if (rt_se_guaranteed(rt_se))
+		rt_rq->rt_nr_guaranteed++;
 
 	if (rt_rq->tg)
 		start_rt_bandwidth(&rt_rq->tg->rt_bandwidth);
@@ -953,8 +1118,11 @@ dec_rt_group(struct sched_rt_entity *rt_se, struct rt_rq *rt_rq)
 {
 	if (rt_se_boosted(rt_se))
 		rt_rq->rt_nr_boosted--;
+	if (rt_se_guaranteed(rt_se))
+		rt_rq->rt_nr_guaranteed--;
 
 	WARN_ON(!rt_rq->rt_nr_running && rt_rq->rt_nr_boosted);
+	WARN_ON(!rt_rq->rt_nr_running && rt_rq->rt_nr_guaranteed);
 }
 
 #else 
@@ -1215,6 +1383,7 @@ static struct task_struct *_pick_next_task_rt(struct rq *rq)
 	struct sched_rt_entity *rt_se;
 	struct task_struct *p;
 	struct rt_rq *rt_rq;
+	int restricted = 0;
 
 	rt_rq = &rq->rt;
 
@@ -1224,10 +1393,20 @@ static struct task_struct *_pick_next_task_rt(struct rq *rq)
 	if (rt_rq_throttled(rt_rq))
 		return NULL;
 
+	/*
+	 * A restricted rt_rq only lets its guaranteed groups through, and
+	 * the restriction holds down to the guaranteed group itself.
+	 */
 	do {
-		rt_se = pick_next_rt_entity(rq, rt_rq);
+		restricted |= rt_rq_restricted(rt_rq);
+		if (restricted)
+			rt_se = pick_guaranteed_rt_entity(rt_rq);
+		else
+			rt_se = pick_next_rt_entity(rq, rt_rq);
 		BUG_ON(!rt_se);
 		rt_rq = group_rt_rq(rt_se);
+		if (rt_rq && rt_rq_guaranteed(rt_rq))
+			restricted = 0;
 	} while (rt_rq);
 
 	p = rt_task_of(rt_se);
@@ -98,6 +98,9 @@ struct task_group {
 	struct rt_rq **rt_rq;
 
 	struct rt_bandwidth rt_bandwidth;
+	int rt_guaranteed;
+	/* to_ratio() bandwidth kept back for guaranteed subgroups */
+	unsigned long rt_reserved_ratio;
 #endif
 
 	struct rcu_head rcu;
@@ -153,6 +156,7 @@ extern int alloc_rt_sched_group(struct task_group *tg, struct task_group *parent
 extern void init_tg_rt_entry(struct task_group *tg, struct rt_rq *rt_rq,
 		struct sched_rt_entity *rt_se, int cpu,
 		struct sched_rt_entity *parent);
+extern void set_rt_group_guaranteed(struct task_group *tg, int guaranteed);
 
 #else 
 
@@ -230,13 +234,23 @@ struct rt_rq {
 	struct plist_head pushable_tasks;
 #endif
 	int rt_throttled;
+	int rt_restricted;
 	u64 rt_time;
 	u64 rt_runtime;
 	
 	raw_spinlock_t rt_runtime_lock;
 
+	u64 rt_nr_throttled;
+	u64 rt_throttled_time;
+	u64 rt_throttled_clock;
+
 #ifdef CONFIG_RT_GROUP_SCHED
 	unsigned long rt_nr_boosted;
+	unsigned long rt_nr_guaranteed;
+	int rt_guaranteed;
+	u64 rt_reserved;
+	/* of rt_time, what guaranteed subgroups ran this period */
+	u64 rt_guaranteed_time;
 
 	struct rq *rq;
 	struct list_head leaf_rt_rq_list;
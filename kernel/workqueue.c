@@ -43,6 +43,8 @@
 #include <linux/lockdep.h>
 #include <linux/idr.h>
 #include <linux/bug.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
 
 #include "workqueue_sched.h"
 
@@ -268,6 +270,7 @@ struct workqueue_struct {
 
 	int			nr_drainers;	
 	int			saved_max_active; 
+	atomic_t		nr_wakeups;	
 #ifdef CONFIG_LOCKDEP
 	struct lockdep_map	lockdep_map;
 #endif
@@ -280,12 +283,22 @@ struct workqueue_struct *system_nrt_wq __read_mostly;
 struct workqueue_struct *system_unbound_wq __read_mostly;
 struct workqueue_struct *system_freezable_wq __read_mostly;
 struct workqueue_struct *system_nrt_freezable_wq __read_mostly;
+struct workqueue_struct *system_power_efficient_wq __read_mostly;
 EXPORT_SYMBOL_GPL(system_wq);
 EXPORT_SYMBOL_GPL(system_long_wq);
 EXPORT_SYMBOL_GPL(system_nrt_wq);
 EXPORT_SYMBOL_GPL(system_unbound_wq);
 EXPORT_SYMBOL_GPL(system_freezable_wq);
 EXPORT_SYMBOL_GPL(system_nrt_freezable_wq);
+EXPORT_SYMBOL_GPL(system_power_efficient_wq);
+
+/*
+ * Workqueues allocated with WQ_POWER_EFFICIENT become unbound when this
+ * is set, so their work runs on a CPU that is already awake instead of
+ * waking the one it was queued from or to.
+ */
+static bool wq_power_efficient = IS_ENABLED(CONFIG_WQ_POWER_EFFICIENT_DEFAULT);
+module_param_named(power_efficient, wq_power_efficient, bool, 0444);
 
 #define CREATE_TRACE_POINTS
 #include <trace/events/workqueue.h>
@@ -844,6 +857,8 @@ static void __queue_work(unsigned int cpu, struct workqueue_struct *wq,
 			}
 		} else
 			spin_lock_irqsave(&gcwq->lock, flags);
+		if (gcwq->cpu != raw_smp_processor_id() && idle_cpu(gcwq->cpu))
+			atomic_inc(&wq->nr_wakeups);
 	} else {
 		gcwq = get_gcwq(WORK_CPU_UNBOUND);
 		spin_lock_irqsave(&gcwq->lock, flags);
@@ -2185,6 +2200,9 @@ struct workqueue_struct *__alloc_workqueue_key(const char *fmt,
 	va_end(args);
 	va_end(args1);
 
+	if ((flags & WQ_POWER_EFFICIENT) && wq_power_efficient)
+		flags |= WQ_UNBOUND;
+
 	if (flags & WQ_MEM_RECLAIM)
 		flags |= WQ_RESCUER;
 
@@ -2949,9 +2967,46 @@ static int __init init_workqueues(void)
 					      WQ_FREEZABLE, 0);
 	system_nrt_freezable_wq = alloc_workqueue("events_nrt_freezable",
 			WQ_NON_REENTRANT | WQ_FREEZABLE, 0);
+	system_power_efficient_wq = alloc_workqueue("events_power_efficient",
+						    WQ_POWER_EFFICIENT, 0);
 	BUG_ON(!system_wq || !system_long_wq || !system_nrt_wq ||
 	       !system_unbound_wq || !system_freezable_wq ||
-		!system_nrt_freezable_wq);
+		!system_nrt_freezable_wq || !system_power_efficient_wq);
 	return 0;
 }
 early_initcall(init_workqueues);
+
+#ifdef CONFIG_DEBUG_FS
+static int wq_wakeups_show(struct seq_file *m, void *unused)
+{
+	struct workqueue_struct *wq;
+
+	spin_lock(&workqueue_lock);
+	list_for_each_entry(wq, &workqueues, list)
+		seq_printf(m, "%-24s %-8s %u\n", wq->name,
+			   wq->flags & WQ_UNBOUND ? "unbound" : "percpu",
+			   atomic_read(&wq->nr_wakeups));
+	spin_unlock(&workqueue_lock);
+	return 0;
+}
+
+static int wq_wakeups_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, wq_wakeups_show, NULL);
+}
+
+static const struct file_operations wq_wakeups_fops = {
+	.open		= wq_wakeups_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static int __init wq_debugfs_init(void)
+{
+	debugfs_create_file("workqueue_wakeups", S_IRUGO, NULL, NULL,
+			    &wq_wakeups_fops);
+	return 0;
+}
+late_initcall(wq_debugfs_init);
+#endif
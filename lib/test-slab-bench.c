@@ -0,0 +1,77 @@
+/*
+ * Slab allocator microbenchmark
+ *
+ * Times kmalloc()/kfree() for a range of object sizes, both as a batch of
+ * allocations followed by the matching frees and as back-to-back
+ * alloc/free pairs that stay on the per-cpu fast path. Results are
+ * printed in nanoseconds per operation when the module is loaded.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+#include <linux/init.h>
+#include <linux/kernel.h>
+#include <linux/module.h>
+#include <linux/slab.h>
+#include <linux/vmalloc.h>
+#include <linux/hrtimer.h>
+
+static unsigned int nr_objects = 10000;
+module_param(nr_objects, uint, 0444);
+
+static void **objs;
+
+static unsigned long ns_per_op(ktime_t start, unsigned int ops)
+{
+	return (unsigned long)div_u64(ktime_to_ns(ktime_sub(ktime_get(),
+							    start)), ops);
+}
+
+static void slab_bench_size(size_t size)
+{
+	unsigned long alloc_ns, free_ns, pair_ns;
+	unsigned int i, nr;
+	ktime_t start;
+
+	start = ktime_get();
+	for (nr = 0; nr < nr_objects; nr++) {
+		objs[nr] = kmalloc(size, GFP_KERNEL);
+		if (!objs[nr])
+			break;
+	}
+	alloc_ns = nr ? ns_per_op(start, nr) : 0;
+
+	start = ktime_get();
+	for (i = 0; i < nr; i++)
+		kfree(objs[i]);
+	free_ns = nr ? ns_per_op(start, nr) : 0;
+
+	start = ktime_get();
+	for (i = 0; i < nr_objects; i++)
+		kfree(kmalloc(size, GFP_KERNEL));
+	pair_ns = ns_per_op(start, nr_objects);
+
+	pr_info("slab_bench: %5zu bytes: alloc %4lu ns, free %4lu ns, "
+		"alloc+free %4lu ns\n", size, alloc_ns, free_ns, pair_ns);
+}
+
+static int __init slab_bench_init(void)
+{
+	size_t size;
+
+	if (!nr_objects)
+		return -EINVAL;
+
+	objs = vmalloc(nr_objects * sizeof(void *));
+	if (!objs)
+		return -ENOMEM;
+
+	for (size = 8; size <= PAGE_SIZE; size <<= 1)
+		slab_bench_size(size);
+
+	vfree(objs);
+	return -EAGAIN;
+}
+module_init(slab_bench_init);
+MODULE_LICENSE("GPL");
@@ -29,6 +29,7 @@
 #include <linux/hardirq.h> 
 #include <linux/memcontrol.h>
 #include <linux/cleancache.h>
+#include <linux/ra_profile.h>
 #include "internal.h"
 
 #include <linux/buffer_head.h> 
@@ -37,7 +38,34 @@
 
 
 
-void __delete_from_page_cache(struct page *page)
+static void page_cache_tree_delete(struct address_space *mapping,
+				   struct page *page, void *shadow)
+{
+	void **slot;
+
+	if (!shadow) {
+		radix_tree_delete(&mapping->page_tree, page->index);
+		return;
+	}
+
+	slot = radix_tree_lookup_slot(&mapping->page_tree, page->index);
+	radix_tree_replace_slot(slot, shadow);
+	mapping->nrshadows++;
+	workingset_shadow_added(mapping);
+	/*
+	 * A final truncate that sees nrpages drop to zero must also see
+	 * the shadow entry, or it would leave it behind.
+	 */
+	smp_wmb();
+}
+
+/*
+ * Remove a page from the page cache and free it. Caller has to make
+ * sure the page is locked and that nobody else uses it - or that usage
+ * is safe.  The caller must hold the mapping's tree_lock. If @shadow is
+ * not NULL it is left in the page's slot to detect a refault.
+ */
+void __delete_from_page_cache(struct page *page, void *shadow)
 {
 	struct address_space *mapping = page->mapping;
 
@@ -46,7 +74,7 @@ void __delete_from_page_cache(struct page *page)
 	else
 		cleancache_invalidate_page(mapping, page);
 
-	radix_tree_delete(&mapping->page_tree, page->index);
+	page_cache_tree_delete(mapping, page, shadow);
 	page->mapping = NULL;
 	
 	mapping->nrpages--;
@@ -70,7 +98,7 @@ void delete_from_page_cache(struct page *page)
 
 	freepage = mapping->a_ops->freepage;
 	spin_lock_irq(&mapping->tree_lock);
-	__delete_from_page_cache(page);
+	__delete_from_page_cache(page, NULL);
 	spin_unlock_irq(&mapping->tree_lock);
 	mem_cgroup_uncharge_cache_page(page);
 
@@ -264,7 +292,7 @@ int replace_page_cache_page(struct page *old, struct page *new, gfp_t gfp_mask)
 		new->index = offset;
 
 		spin_lock_irq(&mapping->tree_lock);
-		__delete_from_page_cache(old);
+		__delete_from_page_cache(old, NULL);
 		error = radix_tree_insert(&mapping->page_tree, offset, new);
 		BUG_ON(error);
 		mapping->nrpages++;
@@ -284,8 +312,31 @@ int replace_page_cache_page(struct page *old, struct page *new, gfp_t gfp_mask)
 }
 EXPORT_SYMBOL_GPL(replace_page_cache_page);
 
-int add_to_page_cache_locked(struct page *page, struct address_space *mapping,
-		pgoff_t offset, gfp_t gfp_mask)
+static int page_cache_tree_insert(struct address_space *mapping,
+				  struct page *page, void **shadowp)
+{
+	void **slot;
+	void *p;
+
+	slot = radix_tree_lookup_slot(&mapping->page_tree, page->index);
+	if (!slot)
+		return radix_tree_insert(&mapping->page_tree, page->index, page);
+
+	p = radix_tree_deref_slot_protected(slot, &mapping->tree_lock);
+	if (!radix_tree_exceptional_entry(p))
+		return -EEXIST;
+	if (shadowp)
+		*shadowp = p;
+	mapping->nrshadows--;
+	workingset_shadow_removed();
+	radix_tree_replace_slot(slot, page);
+	return 0;
+}
+
+static int __add_to_page_cache_locked(struct page *page,
+				      struct address_space *mapping,
+				      pgoff_t offset, gfp_t gfp_mask,
+				      void **shadowp)
 {
 	int error;
 
@@ -304,7 +355,7 @@ int add_to_page_cache_locked(struct page *page, struct address_space *mapping,
 		page->index = offset;
 
 		spin_lock_irq(&mapping->tree_lock);
-		error = radix_tree_insert(&mapping->page_tree, offset, page);
+		error = page_cache_tree_insert(mapping, page, shadowp);
 		if (likely(!error)) {
 			mapping->nrpages++;
 			__inc_zone_page_state(page, NR_FILE_PAGES);
@@ -322,17 +373,35 @@ int add_to_page_cache_locked(struct page *page, struct address_space *mapping,
 out:
 	return error;
 }
+
+int add_to_page_cache_locked(struct page *page, struct address_space *mapping,
+		pgoff_t offset, gfp_t gfp_mask)
+{
+	return __add_to_page_cache_locked(page, mapping, offset,
+					  gfp_mask, NULL);
+}
 EXPORT_SYMBOL(add_to_page_cache_locked);
 
 int add_to_page_cache_lru(struct page *page, struct address_space *mapping,
 				pgoff_t offset, gfp_t gfp_mask)
 {
+	void *shadow = NULL;
 	int ret;
 
-	ret = add_to_page_cache(page, mapping, offset, gfp_mask);
-	if (ret == 0)
+	__set_page_locked(page);
+	ret = __add_to_page_cache_locked(page, mapping, offset,
+					 gfp_mask, &shadow);
+	if (unlikely(ret)) {
+		__clear_page_locked(page);
+		return ret;
+	}
+
+	/* refaulting pages that were part of the working set start active */
+	if (shadow && workingset_refault(shadow))
+		__lru_cache_add(page, LRU_ACTIVE_FILE);
+	else
 		lru_cache_add_file(page);
-	return ret;
+	return 0;
 }
 EXPORT_SYMBOL_GPL(add_to_page_cache_lru);
 
@@ -469,7 +538,11 @@ int __lock_page_or_retry(struct page *page, struct mm_struct *mm,
 	}
 }
 
-struct page *find_get_page(struct address_space *mapping, pgoff_t offset)
+/*
+ * Like find_get_page(), but also returns the exceptional entries that
+ * shmem keeps for swapped out pages and reclaim leaves for evicted ones.
+ */
+struct page *find_get_entry(struct address_space *mapping, pgoff_t offset)
 {
 	void **pagep;
 	struct page *page;
@@ -500,14 +573,24 @@ out:
 
 	return page;
 }
+EXPORT_SYMBOL(find_get_entry);
+
+struct page *find_get_page(struct address_space *mapping, pgoff_t offset)
+{
+	struct page *page = find_get_entry(mapping, offset);
+
+	if (radix_tree_exceptional_entry(page))
+		page = NULL;
+	return page;
+}
 EXPORT_SYMBOL(find_get_page);
 
-struct page *find_lock_page(struct address_space *mapping, pgoff_t offset)
+struct page *find_lock_entry(struct address_space *mapping, pgoff_t offset)
 {
 	struct page *page;
 
 repeat:
-	page = find_get_page(mapping, offset);
+	page = find_get_entry(mapping, offset);
 	if (page && !radix_tree_exception(page)) {
 		lock_page(page);
 		
@@ -520,6 +603,16 @@ repeat:
 	}
 	return page;
 }
+EXPORT_SYMBOL(find_lock_entry);
+
+struct page *find_lock_page(struct address_space *mapping, pgoff_t offset)
+{
+	struct page *page = find_lock_entry(mapping, offset);
+
+	if (radix_tree_exceptional_entry(page))
+		page = NULL;
+	return page;
+}
 EXPORT_SYMBOL(find_lock_page);
 
 struct page *find_or_create_page(struct address_space *mapping,
@@ -743,6 +836,7 @@ static void do_generic_file_read(struct file *filp, loff_t *ppos,
 		unsigned long nr, ret;
 
 		cond_resched();
+		ra_profile_record(mapping, index);
 find_page:
 		page = find_get_page(mapping, index);
 		if (!page) {
@@ -1165,16 +1259,25 @@ int filemap_fault(struct vm_area_struct *vma, struct vm_fault *vmf)
 	struct page *page;
 	pgoff_t size;
 	int ret = 0;
+	int refault = 0;
+	ktime_t start = ktime_set(0, 0);
 
 	size = (i_size_read(inode) + PAGE_CACHE_SIZE - 1) >> PAGE_CACHE_SHIFT;
 	if (offset >= size)
 		return VM_FAULT_SIGBUS;
 
-	page = find_get_page(mapping, offset);
+	ra_profile_record(mapping, offset);
+	page = find_get_entry(mapping, offset);
+	if (radix_tree_exceptional_entry(page)) {
+		/* reclaim evicted this page: rereading it is reclaim's cost */
+		refault = 1;
+		page = NULL;
+	}
 	if (likely(page)) {
 		do_async_mmap_readahead(vma, ra, file, page, offset);
 	} else {
 		
+		start = ktime_get();
 		do_sync_mmap_readahead(vma, ra, file, offset);
 		count_vm_event(PGMAJFAULT);
 		mem_cgroup_count_vm_event(vma->vm_mm, PGMAJFAULT);
@@ -1186,6 +1289,8 @@ retry_find:
 	}
 
 	if (!lock_page_or_retry(page, vma->vm_mm, vmf->flags)) {
+		if (refault)
+			lru_note_cost(page, 1, start);
 		page_cache_release(page);
 		return ret | VM_FAULT_RETRY;
 	}
@@ -1208,6 +1313,8 @@ retry_find:
 		return VM_FAULT_SIGBUS;
 	}
 
+	if (refault)
+		lru_note_cost(page, 1, start);
 	vmf->page = page;
 	return ret | VM_FAULT_LOCKED;
 
@@ -105,7 +105,9 @@ static long madvise_behavior(struct vm_area_struct * vma,
 	}
 
 success:
+	vm_write_begin(vma);
 	vma->vm_flags = new_flags;
+	vm_write_end(vma);
 
 out:
 	if (error == -ENOMEM)
@@ -27,6 +27,7 @@
 #include <linux/swapops.h>
 #include <linux/elf.h>
 #include <linux/gfp.h>
+#include <linux/ra_profile.h>
 
 #include <asm/io.h>
 #include <asm/pgalloc.h>
@@ -421,6 +422,8 @@ void free_pgd_range(struct mmu_gather *tlb,
 void free_pgtables(struct mmu_gather *tlb, struct vm_area_struct *vma,
 		unsigned long floor, unsigned long ceiling)
 {
+	if (vma)
+		spf_sync(vma->vm_mm);
 	while (vma) {
 		struct vm_area_struct *next = vma->vm_next;
 		unsigned long addr = vma->vm_start;
@@ -627,6 +630,38 @@ out:
 }
 
 
+/*
+ * copy_page_range() already skips file mappings without an anon_vma, so
+ * this only matters for private file mappings that have been written to.
+ * Their page cache pages are not copied into the child at fork: it
+ * refaults them from the page cache on first touch, which is cheaper than
+ * copying and tearing down PTEs the child never uses.
+ */
+int sysctl_lazy_fork_min_kbytes __read_mostly = 1024;
+
+static inline bool lazy_fork_vma(struct vm_area_struct *vma)
+{
+	if (!sysctl_lazy_fork_min_kbytes || !vma->vm_file ||
+	    !vma->vm_ops || !vma->vm_ops->fault)
+		return false;
+	if (vma->vm_flags & (VM_HUGETLB|VM_NONLINEAR|VM_PFNMAP|VM_MIXEDMAP|
+			     VM_INSERTPAGE|VM_IO))
+		return false;
+	return vma->vm_end - vma->vm_start >=
+		((unsigned long)sysctl_lazy_fork_min_kbytes << 10);
+}
+
+static inline bool lazy_fork_pte(struct vm_area_struct *vma,
+				 unsigned long addr, pte_t pte)
+{
+	struct page *page;
+
+	if (!pte_present(pte))
+		return false;
+	page = vm_normal_page(vma, addr, pte);
+	return page && !PageAnon(page);
+}
+
 static inline unsigned long
 copy_one_pte(struct mm_struct *dst_mm, struct mm_struct *src_mm,
 		pte_t *dst_pte, pte_t *src_pte, struct vm_area_struct *vma,
@@ -707,6 +742,7 @@ int copy_pte_range(struct mm_struct *dst_mm, struct mm_struct *src_mm,
 	int progress = 0;
 	int rss[NR_MM_COUNTERS];
 	swp_entry_t entry = (swp_entry_t){0};
+	bool lazy = lazy_fork_vma(vma);
 
 again:
 	init_rss_vec(rss);
@@ -728,7 +764,8 @@ again:
 			    spin_needbreak(src_ptl) || spin_needbreak(dst_ptl))
 				break;
 		}
-		if (pte_none(*src_pte)) {
+		if (pte_none(*src_pte) ||
+		    (lazy && lazy_fork_pte(vma, addr, *src_pte))) {
 			progress++;
 			continue;
 		}
@@ -2219,6 +2256,7 @@ static int do_swap_page(struct mm_struct *mm, struct vm_area_struct *vma,
 	struct mem_cgroup *ptr;
 	int exclusive = 0;
 	int ret = 0;
+	ktime_t start = ktime_set(0, 0);
 
 	if (!pte_unmap_same(mm, pmd, page_table, orig_pte))
 		goto out;
@@ -2238,7 +2276,8 @@ static int do_swap_page(struct mm_struct *mm, struct vm_area_struct *vma,
 	delayacct_set_flag(DELAYACCT_PF_SWAPIN);
 	page = lookup_swap_cache(entry);
 	if (!page) {
-		page = swapin_readahead(entry,
+		start = ktime_get();
+		page = swapin_readahead_vma(entry,
 					GFP_HIGHUSER_MOVABLE, vma, address);
 		if (!page) {
 			page_table = pte_offset_map_lock(mm, pmd, address, &ptl);
@@ -2261,6 +2300,8 @@ static int do_swap_page(struct mm_struct *mm, struct vm_area_struct *vma,
 	locked = lock_page_or_retry(page, mm, flags);
 
 	delayacct_clear_flag(DELAYACCT_PF_SWAPIN);
+	if (ret & VM_FAULT_MAJOR)
+		lru_note_cost(page, 0, start);
 	if (!locked) {
 		ret |= VM_FAULT_RETRY;
 		goto out_release;
@@ -2719,6 +2760,271 @@ int handle_mm_fault(struct mm_struct *mm, struct vm_area_struct *vma,
 	return handle_pte_fault(mm, vma, address, pte, pmd, flags);
 }
 
+#ifdef CONFIG_SPECULATIVE_PAGE_FAULT
+int sysctl_speculative_page_fault __read_mostly = 1;
+
+/*
+ * Speculative faults run with preemption disabled and counted in
+ * mm->spf_readers. Writers holding mmap_sem for write call spf_sync()
+ * before they free vmas, anon_vmas or page tables, so everything a
+ * speculative fault can reach stays allocated until it is done. Whether
+ * what it found is still current is checked against mm->mm_rb_seq and
+ * vma->vm_sequence, again under the page table lock: writers bump them
+ * before they go through the page tables of a changed vma.
+ */
+static void spf_begin(struct mm_struct *mm)
+{
+	preempt_disable();
+	atomic_inc(&mm->spf_readers);
+	smp_mb__after_atomic_inc();
+}
+
+static void spf_end(struct mm_struct *mm)
+{
+	smp_mb__before_atomic_dec();
+	atomic_dec(&mm->spf_readers);
+	preempt_enable();
+}
+
+void spf_sync(struct mm_struct *mm)
+{
+	smp_mb();
+	while (atomic_read(&mm->spf_readers))
+		cpu_relax();
+}
+
+/* down_read(&mm->mmap_sem) for faults, accounting the time it takes */
+void fault_down_read_mmap_sem(struct mm_struct *mm)
+{
+	u64 start = local_clock();
+
+	down_read(&mm->mmap_sem);
+	atomic64_add(local_clock() - start, &mm->mmap_sem_wait_ns);
+}
+
+/* deeper than any balanced tree of the vmas a process may have */
+#define SPF_RB_MAX_DEPTH	64
+
+static struct vm_area_struct *spf_find_vma(struct mm_struct *mm,
+					   unsigned long addr)
+{
+	struct rb_node *rb_node = ACCESS_ONCE(mm->mm_rb.rb_node);
+	struct vm_area_struct *vma = NULL;
+	int depth = 0;
+
+	while (rb_node && depth++ < SPF_RB_MAX_DEPTH) {
+		struct vm_area_struct *tmp;
+
+		tmp = rb_entry(rb_node, struct vm_area_struct, vm_rb);
+		if (ACCESS_ONCE(tmp->vm_end) > addr) {
+			vma = tmp;
+			if (ACCESS_ONCE(tmp->vm_start) <= addr)
+				return vma;
+			rb_node = ACCESS_ONCE(rb_node->rb_left);
+		} else
+			rb_node = ACCESS_ONCE(rb_node->rb_right);
+	}
+	return NULL;
+}
+
+/* only the plain page cache fault handler can be done speculatively */
+static struct page *spf_find_cached_page(struct vm_area_struct *vma,
+					 unsigned long address)
+{
+	struct address_space *mapping = vma->vm_file->f_mapping;
+	struct inode *inode = mapping->host;
+	struct page *page;
+	pgoff_t pgoff, size;
+
+	if (vma->vm_ops->fault != filemap_fault || ra_profile_is_recording())
+		return NULL;
+
+	pgoff = ((address - vma->vm_start) >> PAGE_SHIFT) + vma->vm_pgoff;
+	size = (i_size_read(inode) + PAGE_CACHE_SIZE - 1) >> PAGE_CACHE_SHIFT;
+	if (pgoff >= size)
+		return NULL;
+
+	page = find_get_page(mapping, pgoff);
+	if (!page)
+		return NULL;
+	if (!trylock_page(page))
+		goto release;
+	/* leave readahead and errors to filemap_fault() */
+	if (page->mapping != mapping || !PageUptodate(page) ||
+	    PageReadahead(page)) {
+		unlock_page(page);
+		goto release;
+	}
+	return page;
+release:
+	page_cache_release(page);
+	return NULL;
+}
+
+/**
+ * handle_speculative_fault - resolve a page fault without mmap_sem
+ * @mm: faulting mm
+ * @address: faulting address
+ * @flags: FAULT_FLAG_xxx flags
+ * @vm_mask: vm_flags of which the vma needs at least one for this access
+ *
+ * Handles the common faults that need neither I/O nor sleeping
+ * allocations: first touches of anonymous memory, read faults on file
+ * pages that are in the page cache, and access or dirty bit updates of
+ * present ptes. Returns 0 if the fault was handled, or VM_FAULT_RETRY if
+ * the caller has to take mmap_sem and go through handle_mm_fault().
+ */
+int handle_speculative_fault(struct mm_struct *mm, unsigned long address,
+			     unsigned int flags, unsigned long vm_mask)
+{
+	struct vm_area_struct *vma;
+	struct page *page = NULL;
+	unsigned int seq, vseq;
+	unsigned long vm_flags;
+	pgd_t *pgd;
+	pud_t *pud;
+	pmd_t *pmd;
+	pte_t *pte, entry;
+	spinlock_t *ptl;
+	int anon = 0, update = 0;
+
+	if (!sysctl_speculative_page_fault)
+		return VM_FAULT_RETRY;
+
+	address &= PAGE_MASK;
+	spf_begin(mm);
+
+	seq = raw_seqcount_begin(&mm->mm_rb_seq);
+	if (seq != ACCESS_ONCE(mm->mm_rb_seq.sequence))
+		goto fallback;
+	vma = spf_find_vma(mm, address);
+	if (!vma)
+		goto fallback;
+	vseq = raw_seqcount_begin(&vma->vm_sequence);
+	if (vseq != ACCESS_ONCE(vma->vm_sequence.sequence) ||
+	    read_seqcount_retry(&mm->mm_rb_seq, seq))
+		goto fallback;
+
+	vm_flags = ACCESS_ONCE(vma->vm_flags);
+	if (!(vm_flags & vm_mask))
+		goto fallback;
+	if (vm_flags & (VM_HUGETLB | VM_NONLINEAR | VM_PFNMAP | VM_MIXEDMAP |
+			VM_IO | VM_LOCKED | VM_GROWSDOWN | VM_GROWSUP))
+		goto fallback;
+
+	pgd = pgd_offset(mm, address);
+	if (pgd_none(*pgd) || unlikely(pgd_bad(*pgd)))
+		goto fallback;
+	pud = pud_offset(pgd, address);
+	if (pud_none(*pud) || unlikely(pud_bad(*pud)))
+		goto fallback;
+	pmd = pmd_offset(pud, address);
+	if (pmd_none(*pmd) || pmd_trans_huge(*pmd) || unlikely(pmd_bad(*pmd)))
+		goto fallback;
+
+	pte = pte_offset_map(pmd, address);
+	entry = *pte;
+	pte_unmap(pte);
+
+	if (pte_present(entry)) {
+		if ((flags & FAULT_FLAG_WRITE) && !pte_write(entry))
+			goto fallback;
+		update = 1;
+	} else if (!pte_none(entry)) {
+		/* swap, migration and nonlinear entries */
+		goto fallback;
+	} else if (!vma->vm_ops) {
+		if (!(flags & FAULT_FLAG_WRITE)) {
+			entry = pte_mkspecial(pfn_pte(my_zero_pfn(address),
+						      vma->vm_page_prot));
+		} else {
+			if (!vma->anon_vma)
+				goto fallback;
+			/* no sleeping, and no dipping into atomic reserves */
+			page = alloc_page_vma((GFP_HIGHUSER_MOVABLE &
+					       ~__GFP_WAIT) | __GFP_NOMEMALLOC |
+					      __GFP_NOWARN, vma, address);
+			if (!page)
+				goto fallback;
+			clear_user_highpage(page, address);
+			__SetPageUptodate(page);
+			if (mem_cgroup_newpage_charge(page, mm, GFP_NOWAIT)) {
+				page_cache_release(page);
+				goto fallback;
+			}
+			entry = mk_pte(page, vma->vm_page_prot);
+			if (vm_flags & VM_WRITE)
+				entry = pte_mkwrite(pte_mkdirty(entry));
+			anon = 1;
+		}
+	} else {
+		if ((flags & FAULT_FLAG_WRITE) || !vma->vm_ops->fault ||
+		    !vma->vm_file)
+			goto fallback;
+		page = spf_find_cached_page(vma, address);
+		if (!page)
+			goto fallback;
+		entry = mk_pte(page, vma->vm_page_prot);
+	}
+
+	pte = pte_offset_map_lock(mm, pmd, address, &ptl);
+	if (read_seqcount_retry(&vma->vm_sequence, vseq) ||
+	    read_seqcount_retry(&mm->mm_rb_seq, seq))
+		goto unlock_fallback;
+
+	if (update) {
+		/* access flag or dirty bit update of a present pte */
+		if (!pte_same(*pte, entry))
+			goto unlock_fallback;
+		if (flags & FAULT_FLAG_WRITE)
+			entry = pte_mkdirty(entry);
+		entry = pte_mkyoung(entry);
+		if (ptep_set_access_flags(vma, address, pte, entry,
+					  flags & FAULT_FLAG_WRITE))
+			update_mmu_cache(vma, address, pte);
+		else if (flags & FAULT_FLAG_WRITE)
+			flush_tlb_fix_spurious_fault(vma, address);
+		goto done;
+	}
+
+	if (!pte_none(*pte))
+		goto unlock_fallback;
+
+	if (anon) {
+		inc_mm_counter_fast(mm, MM_ANONPAGES);
+		page_add_new_anon_rmap(page, vma, address);
+	} else if (page) {
+		inc_mm_counter_fast(mm, MM_FILEPAGES);
+		page_add_file_rmap(page);
+		unlock_page(page);
+	}
+	set_pte_at(mm, address, pte, entry);
+	update_mmu_cache(vma, address, pte);
+done:
+	pte_unmap_unlock(pte, ptl);
+	spf_end(mm);
+
+	count_vm_event(PGFAULT);
+	mem_cgroup_count_vm_event(mm, PGFAULT);
+	atomic_long_inc(&mm->spf_success);
+	return 0;
+
+unlock_fallback:
+	pte_unmap_unlock(pte, ptl);
+	if (anon) {
+		mem_cgroup_uncharge_page(page);
+		page_cache_release(page);
+	} else if (page) {
+		unlock_page(page);
+		page_cache_release(page);
+	}
+fallback:
+	spf_end(mm);
+	atomic_long_inc(&mm->spf_fallback);
+	return VM_FAULT_RETRY;
+}
+#endif
+
 #ifndef __PAGETABLE_PUD_FOLDED
 int __pud_alloc(struct mm_struct *mm, pgd_t *pgd, unsigned long address)
 {
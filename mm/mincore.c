@@ -12,6 +12,7 @@
 #include <linux/swap.h>
 #include <linux/swapops.h>
 #include <linux/hugetlb.h>
+#include <linux/shmem_fs.h>
 
 #include <asm/uaccess.h>
 #include <asm/pgtable.h>
@@ -51,7 +52,9 @@ static unsigned char mincore_page(struct address_space *mapping, pgoff_t pgoff)
 	unsigned char present = 0;
 	struct page *page;
 
-	page = find_get_page(mapping, pgoff);
+	page = find_get_entry(mapping, pgoff);
+	if (radix_tree_exceptional_entry(page) && !shmem_mapping(mapping))
+		page = NULL;
 #ifdef CONFIG_SWAP
 	
 	if (radix_tree_exceptional_entry(page)) {
@@ -209,9 +209,11 @@ success:
 	mm->locked_vm += nr_pages;
 
 
-	if (lock)
+	if (lock) {
+		vm_write_begin(vma);
 		vma->vm_flags = newflags;
-	else
+		vm_write_end(vma);
+	} else
 		munlock_vma_pages_range(vma, start, end);
 
 out:
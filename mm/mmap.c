@@ -153,6 +153,7 @@ static struct vm_area_struct *remove_vma(struct vm_area_struct *vma)
 	struct vm_area_struct *next = vma->vm_next;
 
 	might_sleep();
+	spf_sync(vma->vm_mm);
 	if (vma->vm_ops && vma->vm_ops->close)
 		vma->vm_ops->close(vma);
 	if (vma->vm_file) {
@@ -309,8 +310,10 @@ find_vma_prepare(struct mm_struct *mm, unsigned long addr,
 void __vma_link_rb(struct mm_struct *mm, struct vm_area_struct *vma,
 		struct rb_node **rb_link, struct rb_node *rb_parent)
 {
+	mm_rb_write_begin(mm);
 	rb_link_node(&vma->vm_rb, rb_parent, rb_link);
 	rb_insert_color(&vma->vm_rb, &mm->mm_rb);
+	mm_rb_write_end(mm);
 }
 
 static void __vma_link_file(struct vm_area_struct *vma)
@@ -386,7 +389,9 @@ __vma_unlink(struct mm_struct *mm, struct vm_area_struct *vma,
 	prev->vm_next = next;
 	if (next)
 		next->vm_prev = prev;
+	mm_rb_write_begin(mm);
 	rb_erase(&vma->vm_rb, &mm->mm_rb);
+	mm_rb_write_end(mm);
 	if (mm->mmap_cache == vma)
 		mm->mmap_cache = prev;
 }
@@ -453,6 +458,9 @@ again:			remove_next = 1 + (end > next->vm_end);
 			vma_prio_tree_remove(next, root);
 	}
 
+	vm_write_begin(vma);
+	if (remove_next || adjust_next)
+		vm_write_begin(next);
 	vma->vm_start = start;
 	vma->vm_end = end;
 	vma->vm_pgoff = pgoff;
@@ -475,6 +483,10 @@ again:			remove_next = 1 + (end > next->vm_end);
 	} else if (insert) {
 		__insert_vm_struct(mm, insert);
 	}
+	/* a removed next is left marked, it is about to be freed */
+	if (adjust_next)
+		vm_write_end(next);
+	vm_write_end(vma);
 
 	if (anon_vma)
 		anon_vma_unlock(anon_vma);
@@ -482,6 +494,8 @@ again:			remove_next = 1 + (end > next->vm_end);
 		mutex_unlock(&mapping->i_mmap_mutex);
 
 	if (remove_next) {
+		/* a speculative fault may still be using next, its policy too */
+		spf_sync(mm);
 		if (file) {
 			fput(file);
 			if (next->vm_flags & VM_EXECUTABLE)
@@ -1494,12 +1508,16 @@ detach_vmas_to_be_unmapped(struct mm_struct *mm, struct vm_area_struct *vma,
 
 	insertion_point = (prev ? &prev->vm_next : &mm->mmap);
 	vma->vm_prev = NULL;
+	mm_rb_write_begin(mm);
 	do {
+		vm_write_begin(vma);
 		rb_erase(&vma->vm_rb, &mm->mm_rb);
+		vm_write_end(vma);
 		mm->map_count--;
 		tail_vma = vma;
 		vma = vma->vm_next;
 	} while (vma && vma->vm_start < end);
+	mm_rb_write_end(mm);
 	*insertion_point = vma;
 	if (vma)
 		vma->vm_prev = prev;
@@ -192,12 +192,23 @@ static unsigned long move_vma(struct vm_area_struct *vma,
 	if (err)
 		return err;
 
+	/*
+	 * A speculative fault must not fill a pte the move has already
+	 * cleared, in the old range until do_munmap() takes it away or in
+	 * the new one before the move reaches it.
+	 */
+	mm_rb_write_begin(mm);
+
 	new_pgoff = vma->vm_pgoff + ((old_addr - vma->vm_start) >> PAGE_SHIFT);
 	new_vma = copy_vma(&vma, new_addr, new_len, new_pgoff);
-	if (!new_vma)
+	if (!new_vma) {
+		mm_rb_write_end(mm);
 		return -ENOMEM;
+	}
 
+	vm_write_begin(vma);
 	moved_len = move_page_tables(vma, old_addr, new_vma, new_addr, old_len);
+	vm_write_end(vma);
 	if (moved_len < old_len) {
 		anon_vma_moveto_tail(vma);
 
@@ -234,6 +245,7 @@ static unsigned long move_vma(struct vm_area_struct *vma,
 		if (split)
 			vma->vm_next->vm_flags |= VM_ACCOUNT;
 	}
+	mm_rb_write_end(mm);
 
 	if (vm_flags & VM_LOCKED) {
 		mm->locked_vm += new_len >> PAGE_SHIFT;
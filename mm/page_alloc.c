@@ -59,6 +59,7 @@
 #include <linux/prefetch.h>
 #include <linux/migrate.h>
 #include <linux/page-debug-flags.h>
+#include <linux/kthread.h>
 
 #include <asm/tlbflush.h>
 #include <asm/div64.h>
@@ -496,6 +497,35 @@ static inline int free_pages_check(struct page *page)
 	return 0;
 }
 
+#ifdef CONFIG_ZONE_LOCK_STAT
+static inline void lock_zone(struct zone *zone)
+{
+	spin_lock(&zone->lock);
+	zone->lock_hold_start = local_clock();
+}
+
+static inline void unlock_zone(struct zone *zone)
+{
+	u64 held = local_clock() - zone->lock_hold_start;
+
+	zone->lock_hold_count++;
+	zone->lock_hold_total_ns += held;
+	if (held > zone->lock_hold_max_ns)
+		zone->lock_hold_max_ns = held;
+	spin_unlock(&zone->lock);
+}
+#else
+static inline void lock_zone(struct zone *zone)
+{
+	spin_lock(&zone->lock);
+}
+
+static inline void unlock_zone(struct zone *zone)
+{
+	spin_unlock(&zone->lock);
+}
+#endif
+
 static void free_pcppages_bulk(struct zone *zone, int count,
 					struct per_cpu_pages *pcp)
 {
@@ -504,7 +534,7 @@ static void free_pcppages_bulk(struct zone *zone, int count,
 	int to_free = count;
 	int mt = 0;
 
-	spin_lock(&zone->lock);
+	lock_zone(zone);
 	zone->all_unreclaimable = 0;
 	zone->pages_scanned = 0;
 
@@ -537,20 +567,20 @@ static void free_pcppages_bulk(struct zone *zone, int count,
 		} while (--to_free && --batch_free && !list_empty(list));
 	}
 	__mod_zone_page_state(zone, NR_FREE_PAGES, count);
-	spin_unlock(&zone->lock);
+	unlock_zone(zone);
 }
 
 static void free_one_page(struct zone *zone, struct page *page, int order,
 				int migratetype)
 {
-	spin_lock(&zone->lock);
+	lock_zone(zone);
 	zone->all_unreclaimable = 0;
 	zone->pages_scanned = 0;
 
 	__free_one_page(page, zone, order, migratetype);
 	if (unlikely(migratetype != MIGRATE_ISOLATE))
 		__mod_zone_freepage_state(zone, 1 << order, migratetype);
-	spin_unlock(&zone->lock);
+	unlock_zone(zone);
 }
 
 static bool free_pages_prepare(struct page *page, unsigned int order)
@@ -959,7 +989,7 @@ static int rmqueue_bulk(struct zone *zone, unsigned int order,
 {
 	int mt = migratetype, i;
 
-	spin_lock(&zone->lock);
+	lock_zone(zone);
 	for (i = 0; i < count; ++i) {
 		struct page *page;
 		if (cma)
@@ -985,7 +1015,7 @@ static int rmqueue_bulk(struct zone *zone, unsigned int order,
 					      -(1 << order));
 	}
 	__mod_zone_page_state(zone, NR_FREE_PAGES, -(i << order));
-	spin_unlock(&zone->lock);
+	unlock_zone(zone);
 	return i;
 }
 
@@ -1263,12 +1293,13 @@ again:
 		if (unlikely(gfp_flags & __GFP_NOFAIL)) {
 			WARN_ON_ONCE(order > 1);
 		}
-		spin_lock_irqsave(&zone->lock, flags);
+		local_irq_save(flags);
+		lock_zone(zone);
 		if (gfp_flags & __GFP_CMA)
 			page = __rmqueue_cma(zone, order, migratetype);
 		else
 			page = __rmqueue(zone, order, migratetype);
-		spin_unlock(&zone->lock);
+		unlock_zone(zone);
 		if (!page)
 			goto failed;
 		__mod_zone_freepage_state(zone, -(1 << order),
@@ -2098,6 +2129,82 @@ out:
 }
 EXPORT_SYMBOL(__alloc_pages_nodemask);
 
+/* pages moved to or from the buddy lists per hold of zone->lock */
+#define PAGES_BULK_BATCH	64
+
+/*
+ * Allocate up to @nr_pages order-0 pages into @pages. Zones that are well
+ * above their low watermark are refilled straight from the buddy lists,
+ * PAGES_BULK_BATCH pages per hold of zone->lock; whatever that cannot
+ * supply comes from the regular allocator, including reclaim. Returns the
+ * number of pages stored, which is less than @nr_pages only on failure.
+ */
+unsigned int alloc_pages_bulk(gfp_t gfp_mask, unsigned int nr_pages,
+			      struct page **pages)
+{
+	enum zone_type high_zoneidx = gfp_zone(gfp_mask);
+	int migratetype = allocflags_to_migratetype(gfp_mask);
+	int cold = !!(gfp_mask & __GFP_COLD);
+	struct zone *preferred_zone, *zone;
+	struct zonelist *zonelist;
+	struct zoneref *z;
+	unsigned int nr = 0;
+
+	gfp_mask &= gfp_allowed_mask;
+	might_sleep_if(gfp_mask & __GFP_WAIT);
+
+	zonelist = node_zonelist(numa_node_id(), gfp_mask);
+	first_zones_zonelist(zonelist, high_zoneidx, NULL, &preferred_zone);
+	if (!preferred_zone)
+		goto fallback;
+
+	for_each_zone_zonelist(zone, z, zonelist, high_zoneidx) {
+		while (nr < nr_pages) {
+			unsigned int batch = min_t(unsigned int, nr_pages - nr,
+						   PAGES_BULK_BATCH);
+			struct page *page, *next;
+			unsigned long flags;
+			LIST_HEAD(list);
+			int got, i;
+
+			if (!zone_watermark_ok(zone, 0,
+					low_wmark_pages(zone) + batch,
+					zone_idx(preferred_zone), 0))
+				break;
+
+			local_irq_save(flags);
+			got = rmqueue_bulk(zone, 0, batch, &list, migratetype,
+					   cold, gfp_mask & __GFP_CMA);
+			__count_zone_vm_events(PGALLOC, zone, got);
+			for (i = 0; i < got; i++)
+				zone_statistics(preferred_zone, zone, gfp_mask);
+			local_irq_restore(flags);
+
+			list_for_each_entry_safe(page, next, &list, lru) {
+				list_del(&page->lru);
+				VM_BUG_ON(bad_range(zone, page));
+				if (!prep_new_page(page, 0, gfp_mask))
+					pages[nr++] = page;
+			}
+			if (got < batch)
+				break;
+		}
+		if (nr == nr_pages)
+			break;
+	}
+
+fallback:
+	while (nr < nr_pages) {
+		struct page *page = alloc_pages(gfp_mask, 0);
+
+		if (!page)
+			break;
+		pages[nr++] = page;
+	}
+	return nr;
+}
+EXPORT_SYMBOL(alloc_pages_bulk);
+
 unsigned long __get_free_pages(gfp_t gfp_mask, unsigned int order)
 {
 	struct page *page;
@@ -2129,6 +2236,70 @@ void __free_pages(struct page *page, unsigned int order)
 
 EXPORT_SYMBOL(__free_pages);
 
+static void free_zone_pages(struct zone *zone, struct list_head *list,
+			    int count)
+{
+	struct page *page, *next;
+	unsigned long flags;
+
+	if (!count)
+		return;
+
+	local_irq_save(flags);
+	__count_vm_events(PGFREE, count);
+	lock_zone(zone);
+	zone->all_unreclaimable = 0;
+	zone->pages_scanned = 0;
+	list_for_each_entry_safe(page, next, list, lru) {
+		int mt = page_private(page);
+
+		list_del(&page->lru);
+		__free_one_page(page, zone, 0, mt);
+		if (likely(mt != MIGRATE_ISOLATE))
+			__mod_zone_freepage_state(zone, 1, mt);
+	}
+	unlock_zone(zone);
+	local_irq_restore(flags);
+}
+
+/*
+ * Drop a reference on each order-0 page of @pages and hand the ones that
+ * become free straight back to the buddy lists, bypassing the per-cpu
+ * lists and taking zone->lock once per PAGES_BULK_BATCH pages. NULL
+ * entries are skipped.
+ */
+void free_pages_bulk(struct page **pages, unsigned int nr_pages)
+{
+	struct zone *zone = NULL;
+	LIST_HEAD(list);
+	unsigned int i;
+	int count = 0;
+
+	for (i = 0; i < nr_pages; i++) {
+		struct page *page = pages[i];
+
+		if (!page || !put_page_testzero(page))
+			continue;
+		if (unlikely(PageMlocked(page))) {
+			free_hot_cold_page(page, 0);
+			continue;
+		}
+		if (!free_pages_prepare(page, 0))
+			continue;
+
+		if (page_zone(page) != zone || count == PAGES_BULK_BATCH) {
+			free_zone_pages(zone, &list, count);
+			zone = page_zone(page);
+			count = 0;
+		}
+		set_page_private(page, get_pageblock_migratetype(page));
+		list_add_tail(&page->lru, &list);
+		count++;
+	}
+	free_zone_pages(zone, &list, count);
+}
+EXPORT_SYMBOL(free_pages_bulk);
+
 void free_pages(unsigned long addr, unsigned int order)
 {
 	if (addr != 0) {
@@ -2910,6 +3081,8 @@ static void setup_zone_migrate_reserve(struct zone *zone)
 
 	start_pfn = zone->zone_start_pfn;
 	end_pfn = start_pfn + zone->spanned_pages;
+	/* struct pages past this may still be set up by the pgdatinit threads */
+	end_pfn = min(end_pfn, deferred_init_pfn());
 	start_pfn = roundup(start_pfn, pageblock_nr_pages);
 	reserve = roundup(min_wmark_pages(zone), pageblock_nr_pages) >>
 							pageblock_order;
@@ -2957,6 +3130,222 @@ static void setup_zone_migrate_reserve(struct zone *zone)
 	}
 }
 
+static void __meminit __init_single_page(struct page *page, unsigned long pfn,
+				unsigned long zone, int nid)
+{
+	set_page_links(page, zone, nid, pfn);
+	mminit_verify_page_links(page, zone, nid, pfn);
+	init_page_count(page);
+	reset_page_mapcount(page);
+	SetPageReserved(page);
+	INIT_LIST_HEAD(&page->lru);
+}
+
+#ifdef CONFIG_DEFERRED_STRUCT_PAGE_INIT
+/*
+ * Only the first DEFERRED_INIT_EARLY_PAGES of the highmem zone get their
+ * struct pages set up on the boot CPU.  The rest is initialized and
+ * handed to the buddy allocator by one kthread per online CPU once SMP
+ * is up, and late_initcall waits for them.  Highmem is never touched by
+ * early boot code, so nothing needs those pages before then.  Initcalls
+ * that walk a zone's struct pages stop at deferred_init_pfn() until the
+ * threads are done.
+ */
+#define DEFERRED_INIT_EARLY_PAGES	(64UL << (20 - PAGE_SHIFT))
+#define DEFERRED_INIT_CHUNK		(pageblock_nr_pages * 8)
+
+static unsigned long deferred_start_pfn;
+static unsigned long deferred_end_pfn;
+static unsigned long deferred_next_pfn;
+static unsigned long deferred_freed;
+static int deferred_nid;
+static unsigned long deferred_zone;
+static DEFINE_SPINLOCK(deferred_lock);
+static atomic_t deferred_threads;
+static DECLARE_COMPLETION(deferred_done);
+static ktime_t deferred_start_time;
+static ktime_t deferred_end_time;
+
+unsigned long deferred_init_pfn(void)
+{
+	if (!deferred_start_pfn || completion_done(&deferred_done))
+		return ULONG_MAX;
+	return deferred_start_pfn;
+}
+
+static unsigned long __init deferred_init_memmap(int nid, unsigned long zone,
+		unsigned long start_pfn, unsigned long end_pfn)
+{
+	unsigned long pfn;
+
+	if (!is_highmem_idx(zone) || deferred_start_pfn ||
+	    end_pfn - start_pfn <= 2 * DEFERRED_INIT_EARLY_PAGES)
+		return end_pfn;
+
+	deferred_start_pfn = ALIGN(start_pfn + DEFERRED_INIT_EARLY_PAGES,
+				   pageblock_nr_pages);
+	deferred_next_pfn = deferred_start_pfn;
+	deferred_end_pfn = end_pfn;
+	deferred_nid = nid;
+	deferred_zone = zone;
+
+	/*
+	 * Pageblock flags of neighbouring blocks share a word and are
+	 * updated non-atomically, so the first page of every block is set
+	 * up here, with its migratetype, before the threads run.
+	 */
+	for (pfn = deferred_start_pfn; pfn < end_pfn; pfn += pageblock_nr_pages) {
+		if (!early_pfn_valid(pfn))
+			continue;
+		__init_single_page(pfn_to_page(pfn), pfn, zone, nid);
+		set_pageblock_migratetype(pfn_to_page(pfn), MIGRATE_MOVABLE);
+	}
+	return deferred_start_pfn;
+}
+
+static unsigned long __init deferred_free_pages(unsigned long pfn,
+						unsigned long end)
+{
+	unsigned long nr = end - pfn;
+	unsigned int order;
+
+	while (pfn < end) {
+		order = min_t(unsigned int, MAX_ORDER - 1, __ffs(pfn));
+		while (pfn + (1UL << order) > end)
+			order--;
+		__free_pages_bootmem(pfn_to_page(pfn), order);
+		pfn += 1UL << order;
+	}
+	return nr;
+}
+
+/* free what memblock says is memory and not reserved, as free_highpages does */
+static unsigned long __init deferred_free_range(unsigned long start,
+						unsigned long end)
+{
+	struct memblock_region *mem, *res;
+	unsigned long freed = 0;
+
+	for_each_memblock(memory, mem) {
+		unsigned long s = max(start, memblock_region_memory_base_pfn(mem));
+		unsigned long e = min(end, memblock_region_memory_end_pfn(mem));
+
+		if (s >= e)
+			continue;
+		for_each_memblock(reserved, res) {
+			unsigned long rs = memblock_region_reserved_base_pfn(res);
+			unsigned long re = memblock_region_reserved_end_pfn(res);
+
+			if (re <= s || rs >= e)
+				continue;
+			if (rs > s)
+				freed += deferred_free_pages(s, rs);
+			s = re;
+			if (s >= e)
+				break;
+		}
+		if (s < e)
+			freed += deferred_free_pages(s, e);
+	}
+	return freed;
+}
+
+/* run by the last to finish; complete_all() keeps completion_done() true */
+static void __init deferred_init_done(void)
+{
+	deferred_end_time = ktime_get();
+	complete_all(&deferred_done);
+}
+
+static int __init deferred_init_thread(void *data)
+{
+	unsigned long start, end, pfn, freed;
+
+	for (;;) {
+		spin_lock(&deferred_lock);
+		start = deferred_next_pfn;
+		end = min(start + DEFERRED_INIT_CHUNK, deferred_end_pfn);
+		deferred_next_pfn = end;
+		spin_unlock(&deferred_lock);
+		if (start >= end)
+			break;
+
+		for (pfn = start; pfn < end; pfn++) {
+			if (!pfn_valid(pfn) || !(pfn & (pageblock_nr_pages - 1)))
+				continue;
+			__init_single_page(pfn_to_page(pfn), pfn,
+					   deferred_zone, deferred_nid);
+		}
+		freed = deferred_free_range(start, end);
+
+		spin_lock(&deferred_lock);
+		deferred_freed += freed;
+		spin_unlock(&deferred_lock);
+		cond_resched();
+	}
+
+	if (atomic_dec_and_test(&deferred_threads))
+		deferred_init_done();
+	return 0;
+}
+
+static int __init deferred_init_start(void)
+{
+	struct task_struct *tsk;
+	int cpu;
+
+	if (!deferred_start_pfn)
+		return 0;
+
+	deferred_start_time = ktime_get();
+	atomic_set(&deferred_threads, 1);
+	for_each_online_cpu(cpu) {
+		tsk = kthread_create_on_node(deferred_init_thread, NULL,
+					     cpu_to_node(cpu), "pgdatinit/%d",
+					     cpu);
+		if (IS_ERR(tsk))
+			continue;
+		kthread_bind(tsk, cpu);
+		atomic_inc(&deferred_threads);
+		wake_up_process(tsk);
+	}
+	/* drop the initial count, and do the work here if no thread started */
+	if (atomic_read(&deferred_threads) == 1)
+		deferred_init_thread(NULL);
+	else if (atomic_dec_and_test(&deferred_threads))
+		deferred_init_done();
+	return 0;
+}
+core_initcall(deferred_init_start);
+
+static int __init deferred_init_wait(void)
+{
+	ktime_t waited;
+
+	if (!deferred_start_pfn)
+		return 0;
+
+	waited = ktime_get();
+	wait_for_completion(&deferred_done);
+	totalram_pages += deferred_freed;
+	totalhigh_pages += deferred_freed;
+
+	pr_info("deferred struct page init: %lu pages (%lu MB) in %lld ms, "
+		"boot waited %lld ms\n", deferred_end_pfn - deferred_start_pfn,
+		deferred_freed >> (20 - PAGE_SHIFT),
+		ktime_to_ms(ktime_sub(deferred_end_time, deferred_start_time)),
+		ktime_to_ms(ktime_sub(ktime_get(), waited)));
+	return 0;
+}
+late_initcall(deferred_init_wait);
+#else
+static inline unsigned long deferred_init_memmap(int nid, unsigned long zone,
+		unsigned long start_pfn, unsigned long end_pfn)
+{
+	return end_pfn;
+}
+#endif
+
 void __meminit memmap_init_zone(unsigned long size, int nid, unsigned long zone,
 		unsigned long start_pfn, enum memmap_context context)
 {
@@ -2969,6 +3358,8 @@ void __meminit memmap_init_zone(unsigned long size, int nid, unsigned long zone,
 		highest_memmap_pfn = end_pfn - 1;
 
 	z = &NODE_DATA(nid)->node_zones[zone];
+	if (context == MEMMAP_EARLY)
+		end_pfn = deferred_init_memmap(nid, zone, start_pfn, end_pfn);
 	for (pfn = start_pfn; pfn < end_pfn; pfn++) {
 		if (context == MEMMAP_EARLY) {
 			if (!early_pfn_valid(pfn))
@@ -2977,17 +3368,12 @@ void __meminit memmap_init_zone(unsigned long size, int nid, unsigned long zone,
 				continue;
 		}
 		page = pfn_to_page(pfn);
-		set_page_links(page, zone, nid, pfn);
-		mminit_verify_page_links(page, zone, nid, pfn);
-		init_page_count(page);
-		reset_page_mapcount(page);
-		SetPageReserved(page);
+		__init_single_page(page, pfn, zone, nid);
 		if ((z->zone_start_pfn <= pfn)
 		    && (pfn < z->zone_start_pfn + z->spanned_pages)
 		    && !(pfn & (pageblock_nr_pages - 1)))
 			set_pageblock_migratetype(page, MIGRATE_MOVABLE);
 
-		INIT_LIST_HEAD(&page->lru);
 #ifdef WANT_PAGE_VIRTUAL
 		
 		if (!is_highmem_idx(zone))
@@ -0,0 +1,396 @@
+/*
+ * mm/readahead_profile.c - per-file readahead profiles
+ *
+ * While recording is enabled, every page a task reads or faults on in a
+ * regular file is noted in a small per-file list of page ranges keyed by
+ * device and inode number.  The profiles can be dumped and loaded back
+ * through debugfs, so userspace can capture an app launch once, store
+ * the result and reload it on the next boot.  While replay is enabled,
+ * the first open of a profiled file issues the recorded ranges as one
+ * sorted, plugged batch of readahead, instead of letting the launch
+ * fault them in one small read at a time.
+ *
+ * debugfs interface (readahead_profile/):
+ *   record    - 1 to record accesses
+ *   replay    - 1 to replay profiles on open
+ *   profiles  - read: "dev ino start+nr ..." per file
+ *               write: same format to load, "clear" to drop everything
+ *   stats     - recording and replay counters
+ *
+ * This work is licensed under the terms of the GNU GPL, version 2.
+ */
+
+#include <linux/kernel.h>
+#include <linux/module.h>
+#include <linux/fs.h>
+#include <linux/mm.h>
+#include <linux/slab.h>
+#include <linux/hash.h>
+#include <linux/blkdev.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
+#include <linux/uaccess.h>
+#include <linux/ra_profile.h>
+
+#define RA_PROFILE_HASH_BITS	8
+#define RA_PROFILE_MAX_FILES	1024
+#define RA_PROFILE_MAX_RANGES	64
+#define RA_PROFILE_MERGE_GAP	4
+
+struct ra_range {
+	pgoff_t start;
+	unsigned long nr;
+};
+
+struct ra_profile {
+	struct hlist_node hash;
+	dev_t dev;
+	unsigned long ino;
+	bool replayed;
+	unsigned int nr_ranges;
+	struct ra_range ranges[RA_PROFILE_MAX_RANGES];
+};
+
+int ra_profile_recording __read_mostly;
+int ra_profile_replaying __read_mostly;
+
+static DEFINE_SPINLOCK(ra_profile_lock);
+static struct hlist_head ra_profile_hash[1 << RA_PROFILE_HASH_BITS];
+static unsigned int ra_profile_files;
+
+static u64 ra_profile_recorded_pages;
+static u64 ra_profile_dropped_pages;
+static u64 ra_profile_replays;
+static u64 ra_profile_replayed_pages;
+
+static struct hlist_head *ra_profile_bucket(dev_t dev, unsigned long ino)
+{
+	return &ra_profile_hash[hash_long(ino ^ dev, RA_PROFILE_HASH_BITS)];
+}
+
+static struct ra_profile *ra_profile_lookup(dev_t dev, unsigned long ino)
+{
+	struct ra_profile *p;
+	struct hlist_node *node;
+
+	hlist_for_each_entry(p, node, ra_profile_bucket(dev, ino), hash)
+		if (p->dev == dev && p->ino == ino)
+			return p;
+	return NULL;
+}
+
+static struct ra_profile *ra_profile_create(dev_t dev, unsigned long ino)
+{
+	struct ra_profile *p;
+
+	if (ra_profile_files >= RA_PROFILE_MAX_FILES)
+		return NULL;
+	p = kzalloc(sizeof(*p), GFP_ATOMIC);
+	if (!p)
+		return NULL;
+	p->dev = dev;
+	p->ino = ino;
+	hlist_add_head(&p->hash, ra_profile_bucket(dev, ino));
+	ra_profile_files++;
+	return p;
+}
+
+static void ra_profile_remove_range(struct ra_profile *p, unsigned int i)
+{
+	p->nr_ranges--;
+	memmove(&p->ranges[i], &p->ranges[i + 1],
+		(p->nr_ranges - i) * sizeof(struct ra_range));
+}
+
+/*
+ * Add [start, start + nr) to the sorted range list, merging with
+ * neighbours closer than RA_PROFILE_MERGE_GAP pages so that a replay
+ * turns into a few large reads rather than many small ones.
+ */
+static bool ra_profile_add(struct ra_profile *p, pgoff_t start,
+			   unsigned long nr)
+{
+	struct ra_range *r;
+	pgoff_t end = start + nr;
+	unsigned int i;
+
+	for (i = 0; i < p->nr_ranges; i++)
+		if (p->ranges[i].start > start)
+			break;
+
+	if (i > 0) {
+		r = &p->ranges[i - 1];
+		if (start <= r->start + r->nr + RA_PROFILE_MERGE_GAP) {
+			if (end > r->start + r->nr)
+				r->nr = end - r->start;
+			goto merge_next;
+		}
+	}
+
+	if (i < p->nr_ranges) {
+		r = &p->ranges[i];
+		if (r->start <= end + RA_PROFILE_MERGE_GAP) {
+			if (r->start + r->nr < end)
+				r->nr = end - start;
+			else
+				r->nr += r->start - start;
+			r->start = start;
+			i++;
+			goto merge_next;
+		}
+	}
+
+	if (p->nr_ranges == RA_PROFILE_MAX_RANGES)
+		return false;
+
+	memmove(&p->ranges[i + 1], &p->ranges[i],
+		(p->nr_ranges - i) * sizeof(struct ra_range));
+	p->ranges[i].start = start;
+	p->ranges[i].nr = nr;
+	p->nr_ranges++;
+	return true;
+
+merge_next:
+	/* ranges[i - 1] grew, swallow whatever it now reaches */
+	r = &p->ranges[i - 1];
+	while (i < p->nr_ranges &&
+	       p->ranges[i].start <= r->start + r->nr + RA_PROFILE_MERGE_GAP) {
+		end = p->ranges[i].start + p->ranges[i].nr;
+		if (end > r->start + r->nr)
+			r->nr = end - r->start;
+		ra_profile_remove_range(p, i);
+	}
+	return true;
+}
+
+void __ra_profile_record(struct address_space *mapping, pgoff_t index)
+{
+	struct inode *inode = mapping->host;
+	struct ra_profile *p;
+
+	if (!inode || !S_ISREG(inode->i_mode))
+		return;
+
+	spin_lock(&ra_profile_lock);
+	p = ra_profile_lookup(inode->i_sb->s_dev, inode->i_ino);
+	if (!p)
+		p = ra_profile_create(inode->i_sb->s_dev, inode->i_ino);
+	if (p && ra_profile_add(p, index, 1))
+		ra_profile_recorded_pages++;
+	else
+		ra_profile_dropped_pages++;
+	spin_unlock(&ra_profile_lock);
+}
+
+void __ra_profile_replay(struct file *file)
+{
+	struct address_space *mapping = file->f_mapping;
+	struct inode *inode = mapping->host;
+	struct ra_range *ranges;
+	struct ra_profile *p;
+	struct blk_plug plug;
+	unsigned long pages = 0;
+	unsigned int i, nr = 0;
+
+	if (!(file->f_mode & FMODE_READ) || !S_ISREG(inode->i_mode) ||
+	    !mapping->a_ops->readpage)
+		return;
+
+	spin_lock(&ra_profile_lock);
+	p = ra_profile_lookup(inode->i_sb->s_dev, inode->i_ino);
+	if (!p || p->replayed || !p->nr_ranges) {
+		spin_unlock(&ra_profile_lock);
+		return;
+	}
+	p->replayed = true;
+	nr = p->nr_ranges;
+	ranges = kmemdup(p->ranges, nr * sizeof(*ranges), GFP_ATOMIC);
+	spin_unlock(&ra_profile_lock);
+	if (!ranges)
+		return;
+
+	blk_start_plug(&plug);
+	for (i = 0; i < nr; i++) {
+		force_page_cache_readahead(mapping, file, ranges[i].start,
+					   ranges[i].nr);
+		pages += ranges[i].nr;
+	}
+	blk_finish_plug(&plug);
+	kfree(ranges);
+
+	spin_lock(&ra_profile_lock);
+	ra_profile_replays++;
+	ra_profile_replayed_pages += pages;
+	spin_unlock(&ra_profile_lock);
+}
+
+static void ra_profile_clear(void)
+{
+	struct ra_profile *p;
+	struct hlist_node *node, *tmp;
+	int i;
+
+	spin_lock(&ra_profile_lock);
+	for (i = 0; i < ARRAY_SIZE(ra_profile_hash); i++) {
+		hlist_for_each_entry_safe(p, node, tmp,
+					  &ra_profile_hash[i], hash) {
+			hlist_del(&p->hash);
+			kfree(p);
+		}
+	}
+	ra_profile_files = 0;
+	spin_unlock(&ra_profile_lock);
+}
+
+static int ra_profile_show(struct seq_file *m, void *v)
+{
+	struct ra_profile *p;
+	struct hlist_node *node;
+	unsigned int i, j;
+
+	spin_lock(&ra_profile_lock);
+	for (i = 0; i < ARRAY_SIZE(ra_profile_hash); i++) {
+		hlist_for_each_entry(p, node, &ra_profile_hash[i], hash) {
+			seq_printf(m, "%u %lu", p->dev, p->ino);
+			for (j = 0; j < p->nr_ranges; j++)
+				seq_printf(m, " %lu+%lu", p->ranges[j].start,
+					   p->ranges[j].nr);
+			seq_putc(m, '\n');
+		}
+	}
+	spin_unlock(&ra_profile_lock);
+	return 0;
+}
+
+static int ra_profile_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, ra_profile_show, NULL);
+}
+
+static int ra_profile_load_line(char *line)
+{
+	struct ra_profile *p;
+	unsigned long start, nr, ino;
+	unsigned int dev;
+	char *tok;
+
+	tok = strsep(&line, " ");
+	if (!tok || kstrtouint(tok, 0, &dev))
+		return -EINVAL;
+	tok = strsep(&line, " ");
+	if (!tok || kstrtoul(tok, 0, &ino))
+		return -EINVAL;
+
+	spin_lock(&ra_profile_lock);
+	p = ra_profile_lookup(dev, ino);
+	if (!p)
+		p = ra_profile_create(dev, ino);
+	if (!p) {
+		spin_unlock(&ra_profile_lock);
+		return -ENOSPC;
+	}
+	p->replayed = false;
+	while ((tok = strsep(&line, " ")) != NULL) {
+		if (!*tok)
+			continue;
+		if (sscanf(tok, "%lu+%lu", &start, &nr) != 2 || !nr)
+			break;
+		if (!ra_profile_add(p, start, nr))
+			break;
+	}
+	spin_unlock(&ra_profile_lock);
+	return 0;
+}
+
+static ssize_t ra_profile_write(struct file *file, const char __user *ubuf,
+				size_t count, loff_t *ppos)
+{
+	char *buf, *line, *next;
+	size_t used = 0;
+	int ret = 0;
+
+	if (count > PAGE_SIZE)
+		count = PAGE_SIZE;
+	buf = kmalloc(count + 1, GFP_KERNEL);
+	if (!buf)
+		return -ENOMEM;
+	if (copy_from_user(buf, ubuf, count)) {
+		kfree(buf);
+		return -EFAULT;
+	}
+	buf[count] = '\0';
+
+	if (!strncmp(buf, "clear", 5)) {
+		ra_profile_clear();
+		kfree(buf);
+		return count;
+	}
+
+	/* only consume whole lines, the rest comes with the next write */
+	for (line = buf; (next = strchr(line, '\n')) != NULL; line = next + 1) {
+		*next = '\0';
+		if (*line) {
+			ret = ra_profile_load_line(line);
+			if (ret)
+				break;
+		}
+		used = next + 1 - buf;
+	}
+	if (!used && !ret && count < PAGE_SIZE) {
+		/* a final line without a newline */
+		ret = ra_profile_load_line(buf);
+		used = count;
+	}
+	kfree(buf);
+	return used ? used : ret ? ret : -EINVAL;
+}
+
+static const struct file_operations ra_profile_fops = {
+	.open		= ra_profile_open,
+	.read		= seq_read,
+	.write		= ra_profile_write,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static int ra_profile_stats_show(struct seq_file *m, void *v)
+{
+	spin_lock(&ra_profile_lock);
+	seq_printf(m, "files %u\n", ra_profile_files);
+	seq_printf(m, "recorded_pages %llu\n", ra_profile_recorded_pages);
+	seq_printf(m, "dropped_pages %llu\n", ra_profile_dropped_pages);
+	seq_printf(m, "replays %llu\n", ra_profile_replays);
+	seq_printf(m, "replayed_pages %llu\n", ra_profile_replayed_pages);
+	spin_unlock(&ra_profile_lock);
+	return 0;
+}
+
+static int ra_profile_stats_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, ra_profile_stats_show, NULL);
+}
+
+static const struct file_operations ra_profile_stats_fops = {
+	.open		= ra_profile_stats_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static int __init ra_profile_init(void)
+{
+	struct dentry *root;
+
+	root = debugfs_create_dir("readahead_profile", NULL);
+	if (!root)
+		return -ENXIO;
+	debugfs_create_bool("record", 0644, root,
+			    (u32 *)&ra_profile_recording);
+	debugfs_create_bool("replay", 0644, root,
+			    (u32 *)&ra_profile_replaying);
+	debugfs_create_file("profiles", 0600, root, NULL, &ra_profile_fops);
+	debugfs_create_file("stats", 0444, root, NULL,
+			    &ra_profile_stats_fops);
+	return 0;
+}
+module_init(ra_profile_init);
@@ -22,6 +22,7 @@
 #include <linux/backing-dev.h>
 #include <linux/memcontrol.h>
 #include <linux/gfp.h>
+#include <linux/hrtimer.h>
 
 #include "internal.h"
 
@@ -237,6 +238,42 @@ static void update_page_reclaim_stat(struct zone *zone, struct page *page,
 		memcg_reclaim_stat->recent_rotated[file]++;
 }
 
+/* forget half of the recorded cost once this much has been seen */
+#define RECLAIM_COST_WINDOW	USEC_PER_SEC
+
+/*
+ * Charge the time since @start, spent swapping an anon page or reading a
+ * file page back in, or compressing an anon page out, to its zone. With
+ * vm.reclaim_cost_balance set, get_scan_count() shifts scanning away from
+ * the more expensive side.
+ */
+void lru_note_cost(struct page *page, int file, ktime_t start)
+{
+	struct zone_reclaim_stat *reclaim_stat;
+	struct zone *zone = page_zone(page);
+	unsigned long flags;
+	s64 usecs;
+
+	usecs = ktime_us_delta(ktime_get(), start);
+	if (usecs <= 0)
+		return;
+	usecs = min_t(s64, usecs, RECLAIM_COST_WINDOW);
+	count_vm_events(file ? RECLAIM_COST_FILE : RECLAIM_COST_ANON, usecs);
+
+	if (!sysctl_reclaim_cost_balance)
+		return;
+
+	reclaim_stat = &zone->reclaim_stat;
+	spin_lock_irqsave(&zone->lru_lock, flags);
+	reclaim_stat->recent_cost[file] += usecs;
+	if (reclaim_stat->recent_cost[0] + reclaim_stat->recent_cost[1] >
+	    RECLAIM_COST_WINDOW) {
+		reclaim_stat->recent_cost[0] /= 2;
+		reclaim_stat->recent_cost[1] /= 2;
+	}
+	spin_unlock_irqrestore(&zone->lru_lock, flags);
+}
+
 static void __activate_page(struct page *page, void *arg)
 {
 	struct zone *zone = page_zone(page);
@@ -299,6 +336,8 @@ void mark_page_accessed(struct page *page)
 			PageReferenced(page) && PageLRU(page)) {
 		activate_page(page);
 		ClearPageReferenced(page);
+		if (page_is_file_cache(page))
+			workingset_activation(page);
 	} else if (!PageReferenced(page)) {
 		SetPageReferenced(page);
 	}
@@ -264,8 +264,14 @@ struct page * lookup_swap_cache(swp_entry_t entry)
 
 	page = find_get_page(&swapper_space, entry.val);
 
-	if (page)
+	if (page) {
 		INC_CACHE_INFO(find_success);
+		/* PG_readahead is PG_reclaim, which writeback may own */
+		if (unlikely(PageReadahead(page)) && !PageWriteback(page)) {
+			ClearPageReadahead(page);
+			atomic_long_inc(&swp_swap_info(entry)->ra_hits);
+		}
+	}
 
 	INC_CACHE_INFO(find_total);
 	return page;
@@ -277,12 +283,14 @@ struct page * lookup_swap_cache(swp_entry_t entry)
  * A failure return means that either the page allocation failed or that
  * the swap entry is no longer in use.
  */
-struct page *read_swap_cache_async(swp_entry_t entry, gfp_t gfp_mask,
-			struct vm_area_struct *vma, unsigned long addr)
+static struct page *__read_swap_cache_async(swp_entry_t entry,
+			gfp_t gfp_mask, struct vm_area_struct *vma,
+			unsigned long addr, bool *new_page_read)
 {
 	struct page *found_page, *new_page = NULL;
 	int err;
 
+	*new_page_read = false;
 	do {
 		/*
 		 * First check the swap cache.  Since this is normally
@@ -333,6 +341,7 @@ struct page *read_swap_cache_async(swp_entry_t entry, gfp_t gfp_mask,
 			 */
 			lru_cache_add_anon(new_page);
 			swap_readpage(new_page);
+			*new_page_read = true;
 			return new_page;
 		}
 		radix_tree_preload_end();
@@ -350,6 +359,37 @@ struct page *read_swap_cache_async(swp_entry_t entry, gfp_t gfp_mask,
 	return found_page;
 }
 
+struct page *read_swap_cache_async(swp_entry_t entry, gfp_t gfp_mask,
+			struct vm_area_struct *vma, unsigned long addr)
+{
+	bool new_page_read;
+
+	return __read_swap_cache_async(entry, gfp_mask, vma, addr,
+				       &new_page_read);
+}
+
+/*
+ * Start reading one readahead page. Pages that were not already in the
+ * swap cache are marked so that lookup_swap_cache() can count the hits.
+ */
+static void swap_readahead_page(swp_entry_t entry, gfp_t gfp_mask,
+			struct vm_area_struct *vma, unsigned long addr,
+			struct swap_info_struct *si)
+{
+	struct page *page;
+	bool new_page_read;
+
+	page = __read_swap_cache_async(entry, gfp_mask, vma, addr,
+				       &new_page_read);
+	if (!page)
+		return;
+	if (new_page_read) {
+		SetPageReadahead(page);
+		atomic_long_inc(&si->ra_pages);
+	}
+	page_cache_release(page);
+}
+
 /**
  * swapin_readahead - swap in pages in hope we need them soon
  * @entry: swap entry of this memory
@@ -372,11 +412,16 @@ struct page *read_swap_cache_async(swp_entry_t entry, gfp_t gfp_mask,
 struct page *swapin_readahead(swp_entry_t entry, gfp_t gfp_mask,
 			struct vm_area_struct *vma, unsigned long addr)
 {
+	struct swap_info_struct *si = swp_swap_info(entry);
 	struct page *page;
-	unsigned long offset = swp_offset(entry);
+	unsigned long entry_offset = swp_offset(entry);
+	unsigned long offset = entry_offset;
 	unsigned long start_offset, end_offset;
 	unsigned long mask = (1UL << page_cluster) - 1;
 
+	if (si->ra_policy != SWAP_RA_CLUSTER)
+		goto skip;
+
 	/* Read a page_cluster sized and aligned cluster around offset. */
 	start_offset = offset & ~mask;
 	end_offset = offset | mask;
@@ -385,12 +430,99 @@ struct page *swapin_readahead(swp_entry_t entry, gfp_t gfp_mask,
 
 	for (offset = start_offset; offset <= end_offset ; offset++) {
 		/* Ok, do the async read-ahead now */
-		page = read_swap_cache_async(swp_entry(swp_type(entry), offset),
-						gfp_mask, vma, addr);
-		if (!page)
+		if (offset == entry_offset) {
+			page = read_swap_cache_async(entry, gfp_mask,
+						     vma, addr);
+			if (page)
+				page_cache_release(page);
 			continue;
-		page_cache_release(page);
+		}
+		swap_readahead_page(swp_entry(swp_type(entry), offset),
+				    gfp_mask, vma, addr, si);
 	}
 	lru_add_drain();	/* Push any new pages onto the LRU now */
+skip:
 	return read_swap_cache_async(entry, gfp_mask, vma, addr);
 }
+
+/* pages around the fault looked at, and how far apart in swap they may be */
+#define SWAP_RA_VMA_MAX		32
+#define SWAP_RA_VMA_DISTANCE	256
+
+/**
+ * swapin_readahead_vma - swap in a faulting page and its vma neighbours
+ * @entry: swap entry of this memory
+ * @gfp_mask: memory allocation flags
+ * @vma: user vma this address belongs to
+ * @addr: faulting address
+ *
+ * On devices with the SWAP_RA_VMA policy, read the faulting page and the
+ * swapped out pages of the surrounding (1 << page_cluster) aligned window
+ * of @vma whose swap slots lie close to @entry, i.e. that were most
+ * likely swapped out together with it. Other devices get their policy
+ * from swapin_readahead().
+ *
+ * Caller must hold down_read on vma->vm_mm.
+ */
+struct page *swapin_readahead_vma(swp_entry_t entry, gfp_t gfp_mask,
+			struct vm_area_struct *vma, unsigned long addr)
+{
+	struct swap_info_struct *si = swp_swap_info(entry);
+	pte_t ptes[SWAP_RA_VMA_MAX];
+	unsigned long win, start, end, a;
+	struct page *page;
+	pgd_t *pgd;
+	pud_t *pud;
+	pmd_t *pmd;
+	pte_t *pte;
+	int i, nr;
+
+	if (si->ra_policy != SWAP_RA_VMA)
+		return swapin_readahead(entry, gfp_mask, vma, addr);
+
+	page = read_swap_cache_async(entry, gfp_mask, vma, addr);
+
+	win = min_t(unsigned long, 1UL << page_cluster, SWAP_RA_VMA_MAX);
+	if (!page || win <= 1)
+		return page;
+
+	start = max(addr & ~((win << PAGE_SHIFT) - 1), vma->vm_start);
+	end = min((addr & ~((win << PAGE_SHIFT) - 1)) + (win << PAGE_SHIFT),
+		  vma->vm_end);
+
+	pgd = pgd_offset(vma->vm_mm, addr);
+	if (pgd_none(*pgd) || pgd_bad(*pgd))
+		return page;
+	pud = pud_offset(pgd, addr);
+	if (pud_none(*pud) || pud_bad(*pud))
+		return page;
+	pmd = pmd_offset(pud, addr);
+	if (pmd_none(*pmd) || pmd_trans_huge(*pmd) || pmd_bad(*pmd))
+		return page;
+
+	nr = (end - start) >> PAGE_SHIFT;
+	pte = pte_offset_map(pmd, start);
+	for (i = 0; i < nr; i++)
+		ptes[i] = pte[i];
+	pte_unmap(pte);
+
+	for (i = 0, a = start; i < nr; i++, a += PAGE_SIZE) {
+		swp_entry_t ra_entry;
+
+		if (a == addr || pte_none(ptes[i]) || pte_present(ptes[i]) ||
+		    pte_file(ptes[i]))
+			continue;
+		ra_entry = pte_to_swp_entry(ptes[i]);
+		if (non_swap_entry(ra_entry) ||
+		    swp_type(ra_entry) != swp_type(entry))
+			continue;
+		if (swp_offset(ra_entry) + SWAP_RA_VMA_DISTANCE <
+		    swp_offset(entry) ||
+		    swp_offset(ra_entry) > swp_offset(entry) +
+		    SWAP_RA_VMA_DISTANCE)
+			continue;
+		swap_readahead_page(ra_entry, gfp_mask, vma, a, si);
+	}
+	lru_add_drain();
+	return page;
+}
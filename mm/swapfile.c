@@ -472,6 +472,11 @@ swp_entry_t get_swap_page_of_type(int type)
 	return (swp_entry_t) {0};
 }
 
+struct swap_info_struct *swp_swap_info(swp_entry_t entry)
+{
+	return swap_info[swp_type(entry)];
+}
+
 static struct swap_info_struct *swap_info_get(swp_entry_t entry)
 {
 	struct swap_info_struct *p;
@@ -1798,9 +1803,93 @@ static const struct file_operations proc_swaps_operations = {
 	.poll		= swaps_poll,
 };
 
+static const char * const swap_ra_policy_names[] = {
+	[SWAP_RA_CLUSTER]	= "cluster",
+	[SWAP_RA_NONE]		= "none",
+	[SWAP_RA_VMA]		= "vma",
+};
+
+static int swap_ra_show(struct seq_file *swap, void *v)
+{
+	struct swap_info_struct *si = v;
+
+	if (si == SEQ_START_TOKEN) {
+		seq_puts(swap, "Type\tPolicy\tReadahead\tHits\tFilename\n");
+		return 0;
+	}
+
+	seq_printf(swap, "%d\t%s\t%lu\t\t%lu\t", si->type,
+		   swap_ra_policy_names[si->ra_policy],
+		   atomic_long_read(&si->ra_pages),
+		   atomic_long_read(&si->ra_hits));
+	seq_path(swap, &si->swap_file->f_path, " \t\n\\");
+	seq_putc(swap, '\n');
+	return 0;
+}
+
+static const struct seq_operations swap_ra_op = {
+	.start =	swap_start,
+	.next =		swap_next,
+	.stop =		swap_stop,
+	.show =		swap_ra_show
+};
+
+static int swap_ra_open(struct inode *inode, struct file *file)
+{
+	return seq_open(file, &swap_ra_op);
+}
+
+/* "<type> <policy>" sets the readahead policy of one swap device */
+static ssize_t swap_ra_write(struct file *file, const char __user *ubuf,
+			     size_t count, loff_t *ppos)
+{
+	struct swap_info_struct *si;
+	char buf[32], name[16];
+	int type, policy;
+
+	if (count >= sizeof(buf))
+		return -EINVAL;
+	if (copy_from_user(buf, ubuf, count))
+		return -EFAULT;
+	buf[count] = '\0';
+
+	if (sscanf(buf, "%d %15s", &type, name) != 2)
+		return -EINVAL;
+	for (policy = 0; policy < ARRAY_SIZE(swap_ra_policy_names); policy++)
+		if (!strcmp(name, swap_ra_policy_names[policy]))
+			break;
+	if (policy == ARRAY_SIZE(swap_ra_policy_names))
+		return -EINVAL;
+
+	mutex_lock(&swapon_mutex);
+	if (type < 0 || type >= nr_swapfiles) {
+		mutex_unlock(&swapon_mutex);
+		return -EINVAL;
+	}
+	si = swap_info[type];
+	if (!(si->flags & SWP_USED) || !si->swap_map) {
+		mutex_unlock(&swapon_mutex);
+		return -ENODEV;
+	}
+	si->ra_policy = policy;
+	mutex_unlock(&swapon_mutex);
+
+	return count;
+}
+
+static const struct file_operations proc_swap_ra_operations = {
+	.open		= swap_ra_open,
+	.read		= seq_read,
+	.write		= swap_ra_write,
+	.llseek		= seq_lseek,
+	.release	= seq_release,
+};
+
 static int __init procswaps_init(void)
 {
 	proc_create("swaps", 0, NULL, &proc_swaps_operations);
+	proc_create("swap_readahead", S_IRUGO | S_IWUSR, NULL,
+		    &proc_swap_ra_operations);
 	return 0;
 }
 __initcall(procswaps_init);
@@ -2108,6 +2197,14 @@ SYSCALL_DEFINE2(swapon, const char __user *, specialfile, int, swap_flags)
 			p->flags |= SWP_DISCARDABLE;
 	}
 
+	/* no seek cost to amortise: only read what the vma suggests */
+	p->ra_policy = SWAP_RA_CLUSTER;
+	if (p->bdev && (bdev_get_queue(p->bdev)->backing_dev_info.capabilities &
+			BDI_CAP_SYNCHRONOUS_IO))
+		p->ra_policy = SWAP_RA_VMA;
+	atomic_long_set(&p->ra_pages, 0);
+	atomic_long_set(&p->ra_hits, 0);
+
 	mutex_lock(&swapon_mutex);
 	prio = -1;
 	if (swap_flags & SWAP_FLAG_PREFER)
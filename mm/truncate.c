@@ -123,6 +123,63 @@ int invalidate_inode_page(struct page *page)
 	return invalidate_complete_page(mapping, page);
 }
 
+/*
+ * Drop the shadow entries reclaim left in [start, end]. They are
+ * collected under RCU in batches and removed under the tree lock, once
+ * it is certain they have not been replaced by a page in the meantime.
+ */
+static void clear_shadow_entries(struct address_space *mapping,
+				 pgoff_t start, pgoff_t end)
+{
+	pgoff_t indices[PAGEVEC_SIZE];
+	struct radix_tree_iter iter;
+	void **slot;
+	int i, nr;
+
+	while (start <= end && mapping->nrshadows) {
+		rcu_read_lock();
+restart:
+		nr = 0;
+		radix_tree_for_each_slot(slot, &mapping->page_tree,
+					 &iter, start) {
+			void *entry;
+
+			if (iter.index > end)
+				break;
+			entry = radix_tree_deref_slot(slot);
+			if (radix_tree_deref_retry(entry))
+				goto restart;
+			if (!radix_tree_exceptional_entry(entry))
+				continue;
+			indices[nr++] = iter.index;
+			if (nr == PAGEVEC_SIZE)
+				break;
+		}
+		rcu_read_unlock();
+		if (!nr)
+			break;
+
+		spin_lock_irq(&mapping->tree_lock);
+		for (i = 0; i < nr; i++) {
+			void *entry;
+
+			entry = radix_tree_lookup(&mapping->page_tree,
+						  indices[i]);
+			if (!radix_tree_exceptional_entry(entry))
+				continue;
+			radix_tree_delete(&mapping->page_tree, indices[i]);
+			mapping->nrshadows--;
+			workingset_shadow_removed();
+		}
+		spin_unlock_irq(&mapping->tree_lock);
+
+		start = indices[nr - 1] + 1;
+		if (!start)
+			break;
+		cond_resched();
+	}
+}
+
 void truncate_inode_pages_range(struct address_space *mapping,
 				loff_t lstart, loff_t lend)
 {
@@ -134,8 +191,12 @@ void truncate_inode_pages_range(struct address_space *mapping,
 	int i;
 
 	cleancache_invalidate_inode(mapping);
-	if (mapping->nrpages == 0)
-		return;
+	if (mapping->nrpages == 0) {
+		/* pairs with the barrier in page_cache_tree_delete() */
+		smp_rmb();
+		if (mapping->nrshadows == 0)
+			return;
+	}
 
 	BUG_ON((lend & (PAGE_CACHE_SIZE - 1)) != (PAGE_CACHE_SIZE - 1));
 	end = (lend >> PAGE_CACHE_SHIFT);
@@ -212,6 +273,7 @@ void truncate_inode_pages_range(struct address_space *mapping,
 		mem_cgroup_uncharge_end();
 		index++;
 	}
+	clear_shadow_entries(mapping, start, end);
 	cleancache_invalidate_inode(mapping);
 }
 EXPORT_SYMBOL(truncate_inode_pages_range);
@@ -277,7 +339,7 @@ invalidate_complete_page2(struct address_space *mapping, struct page *page)
 
 	clear_page_mlock(page);
 	BUG_ON(page_has_private(page));
-	__delete_from_page_cache(page);
+	__delete_from_page_cache(page, NULL);
 	spin_unlock_irq(&mapping->tree_lock);
 	mem_cgroup_uncharge_cache_page(page);
 
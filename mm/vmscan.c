@@ -125,6 +125,7 @@ struct mem_cgroup_zone {
 #endif
 
 int vm_swappiness = 60;
+int sysctl_reclaim_cost_balance __read_mostly;
 long vm_total_pages;	
 
 static LIST_HEAD(shrinker_list);
@@ -361,7 +362,8 @@ static pageout_t pageout(struct page *page, struct address_space *mapping,
 	return PAGE_CLEAN;
 }
 
-static int __remove_mapping(struct address_space *mapping, struct page *page)
+static int __remove_mapping(struct address_space *mapping, struct page *page,
+			    bool reclaimed)
 {
 	BUG_ON(!PageLocked(page));
 	BUG_ON(mapping != page_mapping(page));
@@ -382,10 +384,13 @@ static int __remove_mapping(struct address_space *mapping, struct page *page)
 		swapcache_free(swap, page);
 	} else {
 		void (*freepage)(struct page *);
+		void *shadow = NULL;
 
 		freepage = mapping->a_ops->freepage;
 
-		__delete_from_page_cache(page);
+		if (reclaimed && page_is_file_cache(page))
+			shadow = workingset_eviction(mapping, page);
+		__delete_from_page_cache(page, shadow);
 		spin_unlock_irq(&mapping->tree_lock);
 		mem_cgroup_uncharge_cache_page(page);
 
@@ -402,7 +407,7 @@ cannot_free:
 
 int remove_mapping(struct address_space *mapping, struct page *page)
 {
-	if (__remove_mapping(mapping, page)) {
+	if (__remove_mapping(mapping, page, false)) {
 		page_unfreeze_refs(page, 1);
 		return 1;
 	}
@@ -511,6 +516,7 @@ static unsigned long shrink_page_list(struct list_head *page_list,
 		struct address_space *mapping;
 		struct page *page;
 		int may_enter_fs;
+		pageout_t ret;
 		enum page_references references = PAGEREF_RECLAIM_CLEAN;
 
 		cond_resched();
@@ -606,8 +612,15 @@ static unsigned long shrink_page_list(struct list_head *page_list,
 			if (!sc->may_writepage)
 				goto keep_locked;
 
-			
-			switch (pageout(page, mapping, sc)) {
+			if (PageSwapCache(page)) {
+				ktime_t start = ktime_get();
+
+				ret = pageout(page, mapping, sc);
+				lru_note_cost(page, 0, start);
+			} else
+				ret = pageout(page, mapping, sc);
+
+			switch (ret) {
 			case PAGE_KEEP:
 				nr_congested++;
 				goto keep_locked;
@@ -664,7 +677,7 @@ static unsigned long shrink_page_list(struct list_head *page_list,
 			}
 		}
 
-		if (!mapping || !__remove_mapping(mapping, page))
+		if (!mapping || !__remove_mapping(mapping, page, true))
 			goto keep_locked;
 
 		__clear_page_locked(page);
@@ -1330,6 +1343,22 @@ static void get_scan_count(struct mem_cgroup_zone *mz, struct scan_control *sc,
 
 	fp = file_prio * (reclaim_stat->recent_scanned[1] + 1);
 	fp /= reclaim_stat->recent_rotated[1] + 1;
+
+	/*
+	 * And to the time recently spent getting reclaimed pages of each
+	 * type back: swap on zram is far cheaper than rereading executable
+	 * pages from flash. Each side keeps at least half its pressure.
+	 */
+	if (sysctl_reclaim_cost_balance && global_reclaim(sc)) {
+		struct zone_reclaim_stat *zstat = &mz->zone->reclaim_stat;
+		unsigned long total;
+
+		total = zstat->recent_cost[0] + zstat->recent_cost[1];
+		ap = div64_u64((u64)ap * (total + 1),
+			       total + zstat->recent_cost[0] + 1);
+		fp = div64_u64((u64)fp * (total + 1),
+			       total + zstat->recent_cost[1] + 1);
+	}
 	spin_unlock_irq(&mz->zone->lru_lock);
 
 	fraction[0] = ap;
@@ -533,6 +533,8 @@ const char * const vmstat_text[] = {
 	"nr_shmem",
 	"nr_dirtied",
 	"nr_written",
+	"workingset_refault",
+	"workingset_activate",
 
 #ifdef CONFIG_NUMA
 	"numa_hit",
@@ -581,6 +583,12 @@ const char * const vmstat_text[] = {
 	"allocstall",
 
 	"pgrotated",
+	"reclaim_cost_anon_us",
+	"reclaim_cost_file_us",
+	"refault_distance_0_25",
+	"refault_distance_25_50",
+	"refault_distance_50_100",
+	"refault_distance_100_plus",
 
 #ifdef CONFIG_MIGRATION
 	"pgmigrate_success",
@@ -842,6 +850,15 @@ static void zoneinfo_show_print(struct seq_file *m, pg_data_t *pgdat,
 		   zone->all_unreclaimable,
 		   zone->zone_start_pfn,
 		   zone->inactive_ratio);
+#ifdef CONFIG_ZONE_LOCK_STAT
+	seq_printf(m,
+		   "\n  lock holds:        %lu"
+		   "\n  lock held ns:      %llu"
+		   "\n  lock max held ns:  %llu",
+		   zone->lock_hold_count,
+		   (unsigned long long)zone->lock_hold_total_ns,
+		   (unsigned long long)zone->lock_hold_max_ns);
+#endif
 	seq_putc(m, '\n');
 }
 
@@ -0,0 +1,270 @@
+/*
+ * mm/workingset.c - page cache refault detection
+ *
+ * Every zone keeps a counter, inactive_age, that advances whenever a
+ * file page leaves its inactive list: on eviction and on activation.
+ * When reclaim evicts a file page, the current counter value is left in
+ * the page cache radix tree as an exceptional "shadow" entry in place of
+ * the page.
+ *
+ * If the page is faulted back in, the difference between the counter
+ * and the value in the shadow entry, the refault distance, is the number
+ * of pages that left the inactive list while the page was out. Had the
+ * inactive list been that many pages longer, the page would still have
+ * been cached. The inactive list can only grow at the expense of the
+ * active list, so a page whose refault distance is no larger than the
+ * active list is part of the working set and it starts out active,
+ * competing with the active pages instead of being evicted again by
+ * the next batch of used-once pages.
+ *
+ * Shadow entries pin radix tree nodes, and a long-lived inode such as a
+ * block device's would collect them without bound. A refault can only
+ * activate a page whose distance fits into the active list, so once the
+ * system holds more shadow entries than active file pages, a shrinker
+ * drops them, going round the mappings that hold any.
+ *
+ * This work is licensed under the terms of the GNU GPL, version 2.
+ */
+
+#include <linux/mm.h>
+#include <linux/mmzone.h>
+#include <linux/fs.h>
+#include <linux/swap.h>
+#include <linux/radix-tree.h>
+#include <linux/spinlock.h>
+#include <linux/vmstat.h>
+#include <linux/module.h>
+
+#define EVICTION_SHIFT	(RADIX_TREE_EXCEPTIONAL_SHIFT + \
+			 ZONES_SHIFT + NODES_SHIFT)
+#define EVICTION_MASK	(~0UL >> EVICTION_SHIFT)
+
+static void *pack_shadow(unsigned long eviction, struct zone *zone)
+{
+	eviction = (eviction << NODES_SHIFT) | zone_to_nid(zone);
+	eviction = (eviction << ZONES_SHIFT) | zone_idx(zone);
+	eviction = (eviction << RADIX_TREE_EXCEPTIONAL_SHIFT);
+
+	return (void *)(eviction | RADIX_TREE_EXCEPTIONAL_ENTRY);
+}
+
+static void unpack_shadow(void *shadow, struct zone **zone,
+			  unsigned long *distance)
+{
+	unsigned long entry = (unsigned long)shadow;
+	unsigned long eviction, refault;
+	int zid, nid;
+
+	entry >>= RADIX_TREE_EXCEPTIONAL_SHIFT;
+	zid = entry & ((1UL << ZONES_SHIFT) - 1);
+	entry >>= ZONES_SHIFT;
+	nid = entry & ((1UL << NODES_SHIFT) - 1);
+	entry >>= NODES_SHIFT;
+	eviction = entry;
+
+	*zone = NODE_DATA(nid)->node_zones + zid;
+
+	/* the counter may have wrapped since, within EVICTION_MASK */
+	refault = atomic_long_read(&(*zone)->inactive_age);
+	*distance = (refault - eviction) & EVICTION_MASK;
+}
+
+/**
+ * workingset_eviction - note the eviction of a page from memory
+ * @mapping: address space the page was backing
+ * @page: the page being evicted
+ *
+ * Returns a shadow entry to be stored in @mapping->page_tree in place
+ * of the evicted @page so that a later refault can be detected.
+ */
+void *workingset_eviction(struct address_space *mapping, struct page *page)
+{
+	struct zone *zone = page_zone(page);
+	unsigned long eviction;
+
+	/* only inode data mappings are taken off the shadow list on eviction */
+	if (!mapping->host || mapping != &mapping->host->i_data)
+		return NULL;
+
+	eviction = atomic_long_inc_return(&zone->inactive_age);
+	return pack_shadow(eviction, zone);
+}
+
+/**
+ * workingset_refault - evaluate the refault of a previously evicted page
+ * @shadow: shadow entry of the evicted page
+ *
+ * Returns %true if the page should be activated, %false otherwise.
+ */
+bool workingset_refault(void *shadow)
+{
+	unsigned long refault_distance, active;
+	struct zone *zone;
+
+	unpack_shadow(shadow, &zone, &refault_distance);
+	inc_zone_state(zone, WORKINGSET_REFAULT);
+
+	/* how far into or past the active list the page would have fit */
+	active = zone_page_state(zone, NR_ACTIVE_FILE);
+	if (refault_distance <= active / 4)
+		count_vm_event(REFAULT_DISTANCE_25);
+	else if (refault_distance <= active / 2)
+		count_vm_event(REFAULT_DISTANCE_50);
+	else if (refault_distance <= active)
+		count_vm_event(REFAULT_DISTANCE_100);
+	else
+		count_vm_event(REFAULT_DISTANCE_FAR);
+
+	if (refault_distance <= active) {
+		inc_zone_state(zone, WORKINGSET_ACTIVATE);
+		return true;
+	}
+	return false;
+}
+
+/**
+ * workingset_activation - note a page activation
+ * @page: page that is being activated
+ */
+void workingset_activation(struct page *page)
+{
+	atomic_long_inc(&page_zone(page)->inactive_age);
+}
+
+/*
+ * Mappings that hold shadow entries, in the order they got their first
+ * one. Nests inside the mapping's tree_lock.
+ */
+static LIST_HEAD(shadow_mappings);
+static DEFINE_SPINLOCK(shadow_lock);
+static atomic_long_t nr_shadows = ATOMIC_LONG_INIT(0);
+
+#define SHADOW_SCAN_SLOTS	64
+#define SHADOW_BATCH		16
+
+/*
+ * workingset_shadow_added - account a shadow entry stored in @mapping
+ *
+ * Called with the mapping's tree_lock held.
+ */
+void workingset_shadow_added(struct address_space *mapping)
+{
+	atomic_long_inc(&nr_shadows);
+	if (list_empty(&mapping->shadow_list)) {
+		spin_lock(&shadow_lock);
+		list_add_tail(&mapping->shadow_list, &shadow_mappings);
+		spin_unlock(&shadow_lock);
+	}
+}
+
+void workingset_shadow_removed(void)
+{
+	atomic_long_dec(&nr_shadows);
+}
+
+/**
+ * workingset_forget_mapping - take a dying mapping off the shadow list
+ * @mapping: mapping of an inode being evicted, without shadow entries
+ */
+void workingset_forget_mapping(struct address_space *mapping)
+{
+	if (list_empty(&mapping->shadow_list))
+		return;
+
+	spin_lock_irq(&shadow_lock);
+	list_del_init(&mapping->shadow_list);
+	spin_unlock_irq(&shadow_lock);
+}
+
+/*
+ * Drop up to SHADOW_BATCH shadow entries of @mapping, scanning at most
+ * SHADOW_SCAN_SLOTS entries from where the last pass stopped. Called with
+ * the tree_lock held. Returns the number of entries scanned.
+ */
+static int shrink_mapping_shadows(struct address_space *mapping)
+{
+	pgoff_t indices[SHADOW_BATCH];
+	struct radix_tree_iter iter;
+	pgoff_t start = mapping->shadow_index;
+	int scanned = 0, nr = 0, i;
+	void **slot;
+
+	/* start over next time unless the scan stops early */
+	mapping->shadow_index = 0;
+	radix_tree_for_each_slot(slot, &mapping->page_tree, &iter, start) {
+		void *entry = radix_tree_deref_slot_protected(slot,
+						&mapping->tree_lock);
+
+		if (radix_tree_exceptional_entry(entry))
+			indices[nr++] = iter.index;
+		if (++scanned == SHADOW_SCAN_SLOTS || nr == SHADOW_BATCH) {
+			mapping->shadow_index = iter.index + 1;
+			break;
+		}
+	}
+
+	for (i = 0; i < nr; i++) {
+		radix_tree_delete(&mapping->page_tree, indices[i]);
+		mapping->nrshadows--;
+		workingset_shadow_removed();
+	}
+	return scanned;
+}
+
+static long shadow_excess(void)
+{
+	return atomic_long_read(&nr_shadows) -
+	       (long)global_page_state(NR_ACTIVE_FILE);
+}
+
+static int shrink_shadows(struct shrinker *shrink, struct shrink_control *sc)
+{
+	long nr_to_scan = sc->nr_to_scan;
+	long excess;
+
+	while (nr_to_scan > 0 && shadow_excess() > 0) {
+		struct address_space *mapping;
+		int scanned = 1, empty = 0;
+
+		spin_lock_irq(&shadow_lock);
+		if (list_empty(&shadow_mappings)) {
+			spin_unlock_irq(&shadow_lock);
+			break;
+		}
+		mapping = list_first_entry(&shadow_mappings,
+					   struct address_space, shadow_list);
+		list_move_tail(&mapping->shadow_list, &shadow_mappings);
+		/*
+		 * While on the list, the mapping cannot go away: eviction
+		 * takes it off under shadow_lock. Once it is off, it must
+		 * not be touched again.
+		 */
+		if (spin_trylock(&mapping->tree_lock)) {
+			if (mapping->nrshadows)
+				scanned = shrink_mapping_shadows(mapping);
+			empty = !mapping->nrshadows;
+			spin_unlock(&mapping->tree_lock);
+		}
+		if (empty)
+			list_del_init(&mapping->shadow_list);
+		spin_unlock_irq(&shadow_lock);
+
+		nr_to_scan -= scanned;
+		cond_resched();
+	}
+
+	excess = shadow_excess();
+	return excess > 0 ? min_t(long, excess, INT_MAX) : 0;
+}
+
+static struct shrinker shadow_shrinker = {
+	.shrink = shrink_shadows,
+	.seeks = DEFAULT_SEEKS,
+};
+
+static int __init workingset_init(void)
+{
+	register_shrinker(&shadow_shrinker);
+	return 0;
+}
+module_init(workingset_init);
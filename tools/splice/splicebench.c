@@ -0,0 +1,255 @@
+/*
+ * splicebench - compare read()+write() against sendfile() and splice()
+ *
+ * Streams a file either to a local TCP socket (drained by a sink thread)
+ * or to an arbitrary writable path such as /dev/android_adb, and reports
+ * the throughput of each copy method.  Run it on a file that is already
+ * in the page cache to measure the copy cost rather than the storage.
+ *
+ *   splicebench [-m rw|sendfile|splice|all] [-b bufsize] [-n loops]
+ *               [-o outpath] file
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <time.h>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/sendfile.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+enum method { M_RW, M_SENDFILE, M_SPLICE, M_MAX };
+
+static const char *method_names[M_MAX] = { "rw", "sendfile", "splice" };
+
+static size_t bufsize = 64 * 1024;
+
+static void die(const char *what)
+{
+	perror(what);
+	exit(1);
+}
+
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void *sink_thread(void *arg)
+{
+	int fd = *(int *)arg;
+	char buf[64 * 1024];
+
+	while (read(fd, buf, sizeof(buf)) > 0)
+		;
+	close(fd);
+	return NULL;
+}
+
+/* connect a TCP socket over loopback to a thread that discards the data */
+static int open_tcp_sink(pthread_t *thread)
+{
+	struct sockaddr_in addr;
+	socklen_t len = sizeof(addr);
+	static int conn;
+	int lfd, fd;
+
+	lfd = socket(AF_INET, SOCK_STREAM, 0);
+	if (lfd < 0)
+		die("socket");
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	if (bind(lfd, (struct sockaddr *)&addr, sizeof(addr)) ||
+	    listen(lfd, 1) ||
+	    getsockname(lfd, (struct sockaddr *)&addr, &len))
+		die("listen");
+
+	fd = socket(AF_INET, SOCK_STREAM, 0);
+	if (fd < 0)
+		die("socket");
+	if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)))
+		die("connect");
+	conn = accept(lfd, NULL, NULL);
+	if (conn < 0)
+		die("accept");
+	close(lfd);
+
+	if (pthread_create(thread, NULL, sink_thread, &conn))
+		die("pthread_create");
+	return fd;
+}
+
+static ssize_t copy_rw(int in, int out, size_t count)
+{
+	static char *buf;
+	size_t done = 0;
+	ssize_t r, w;
+
+	if (!buf && !(buf = malloc(bufsize)))
+		die("malloc");
+
+	while (done < count) {
+		r = read(in, buf, bufsize);
+		if (r <= 0)
+			return r < 0 ? r : (ssize_t)done;
+		for (w = 0; w < r; ) {
+			ssize_t n = write(out, buf + w, r - w);
+			if (n < 0)
+				return n;
+			w += n;
+		}
+		done += r;
+	}
+	return done;
+}
+
+static ssize_t copy_sendfile(int in, int out, size_t count)
+{
+	size_t done = 0;
+	ssize_t n;
+
+	while (done < count) {
+		n = sendfile(out, in, NULL, count - done);
+		if (n <= 0)
+			return n < 0 ? n : (ssize_t)done;
+		done += n;
+	}
+	return done;
+}
+
+static ssize_t copy_splice(int in, int out, size_t count)
+{
+	static int pfd[2] = { -1, -1 };
+	size_t done = 0;
+	ssize_t n, m;
+
+	if (pfd[0] < 0 && pipe(pfd))
+		die("pipe");
+
+	while (done < count) {
+		n = splice(in, NULL, pfd[1], NULL, bufsize, SPLICE_F_MOVE);
+		if (n <= 0)
+			return n < 0 ? n : (ssize_t)done;
+		while (n > 0) {
+			m = splice(pfd[0], NULL, out, NULL, n,
+				   SPLICE_F_MOVE | SPLICE_F_MORE);
+			if (m <= 0)
+				return -1;
+			n -= m;
+			done += m;
+		}
+	}
+	return done;
+}
+
+static ssize_t (*const copy_fn[M_MAX])(int, int, size_t) = {
+	copy_rw, copy_sendfile, copy_splice,
+};
+
+static void run(enum method m, const char *file, const char *outpath,
+		int loops)
+{
+	struct stat st;
+	pthread_t sink;
+	double start, elapsed;
+	size_t total = 0;
+	int in, out, i;
+
+	in = open(file, O_RDONLY);
+	if (in < 0 || fstat(in, &st))
+		die(file);
+
+	if (outpath) {
+		out = open(outpath, O_WRONLY);
+		if (out < 0)
+			die(outpath);
+	} else {
+		out = open_tcp_sink(&sink);
+	}
+
+	start = now();
+	for (i = 0; i < loops; i++) {
+		ssize_t n;
+
+		if (lseek(in, 0, SEEK_SET))
+			die("lseek");
+		n = copy_fn[m](in, out, st.st_size);
+		if (n < 0)
+			die(method_names[m]);
+		total += n;
+	}
+	elapsed = now() - start;
+
+	close(out);
+	if (!outpath)
+		pthread_join(sink, NULL);
+	close(in);
+
+	printf("%-9s %10zu bytes %8.3f s %9.2f MB/s\n", method_names[m],
+	       total, elapsed, total / elapsed / (1024 * 1024));
+}
+
+static void usage(const char *prog)
+{
+	fprintf(stderr, "usage: %s [-m rw|sendfile|splice|all] [-b bufsize] "
+		"[-n loops] [-o outpath] file\n", prog);
+	exit(2);
+}
+
+int main(int argc, char **argv)
+{
+	const char *outpath = NULL;
+	int first = 0, last = M_MAX - 1;
+	int loops = 10;
+	int opt, m;
+
+	while ((opt = getopt(argc, argv, "m:b:n:o:")) != -1) {
+		switch (opt) {
+		case 'm':
+			if (!strcmp(optarg, "all"))
+				break;
+			for (m = 0; m < M_MAX; m++)
+				if (!strcmp(optarg, method_names[m]))
+					break;
+			if (m == M_MAX)
+				usage(argv[0]);
+			first = last = m;
+			break;
+		case 'b':
+			bufsize = strtoul(optarg, NULL, 0);
+			break;
+		case 'n':
+			loops = atoi(optarg);
+			break;
+		case 'o':
+			outpath = optarg;
+			break;
+		default:
+			usage(argv[0]);
+		}
+	}
+	if (optind != argc - 1 || !bufsize || loops <= 0)
+		usage(argv[0]);
+
+	for (m = first; m <= last; m++)
+		run(m, argv[optind], outpath, loops);
+	return 0;
+}
@@ -0,0 +1,197 @@
+/*
+ * forkbench - measure fork() latency of a process with a large RSS
+ *
+ * Builds a zygote-like address space: a private mapping of a file that is
+ * read in full, plus touched anonymous memory. It then forks repeatedly and
+ * reports how long fork() takes in the parent and how long a child that
+ * reads part of the file mapping takes to exit.
+ *
+ * By default the file mapping is only read, like boot image, odex and
+ * library text. -w N also dirties one file page in N, like relocated
+ * library data; only then does /proc/sys/vm/lazy_fork_min_kbytes change
+ * anything, so compare runs with it set to 0 and to its default.
+ *
+ *   forkbench [-s size_mb] [-f file_percent] [-t touch_percent]
+ *             [-w dirty_interval] [-n loops] [-d dir]
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+
+#include <sys/types.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+static size_t page_size;
+
+static double now_us(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static void die(const char *msg)
+{
+	perror(msg);
+	exit(1);
+}
+
+static char *map_file(const char *dir, size_t len)
+{
+	char path[256];
+	char *buf, *map;
+	size_t off;
+	int fd;
+
+	snprintf(path, sizeof(path), "%s/forkbench.XXXXXX", dir);
+	fd = mkstemp(path);
+	if (fd < 0)
+		die("mkstemp");
+	unlink(path);
+
+	buf = malloc(1 << 20);
+	if (!buf)
+		die("malloc");
+	memset(buf, 0x5a, 1 << 20);
+	for (off = 0; off < len; off += 1 << 20) {
+		size_t chunk = len - off < (1 << 20) ? len - off : (1 << 20);
+
+		if (write(fd, buf, chunk) != (ssize_t)chunk)
+			die("write");
+	}
+	free(buf);
+
+	map = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+	if (map == MAP_FAILED)
+		die("mmap file");
+	close(fd);
+	return map;
+}
+
+static unsigned long touch(char *map, size_t len, size_t stride, int write)
+{
+	unsigned long sum = 0;
+	size_t off;
+
+	for (off = 0; off < len; off += stride) {
+		if (write)
+			map[off] = 1;
+		else
+			sum += map[off];
+	}
+	return sum;
+}
+
+static void usage(const char *prog)
+{
+	fprintf(stderr, "usage: %s [-s size_mb] [-f file_percent] "
+		"[-t touch_percent] [-w dirty_interval] [-n loops] "
+		"[-d dir]\n", prog);
+	exit(1);
+}
+
+int main(int argc, char **argv)
+{
+	size_t size_mb = 200, file_len, anon_len, touch_len;
+	int file_pct = 75, touch_pct = 10, dirty = 0, loops = 20;
+	const char *dir = "/data/local/tmp";
+	double fork_min = 1e12, fork_max = 0, fork_sum = 0, child_sum = 0;
+	char *file_map, *anon_map;
+	int opt, i;
+
+	while ((opt = getopt(argc, argv, "s:f:t:w:n:d:")) != -1) {
+		switch (opt) {
+		case 's':
+			size_mb = strtoul(optarg, NULL, 0);
+			break;
+		case 'f':
+			file_pct = atoi(optarg);
+			break;
+		case 't':
+			touch_pct = atoi(optarg);
+			break;
+		case 'w':
+			dirty = atoi(optarg);
+			break;
+		case 'n':
+			loops = atoi(optarg);
+			break;
+		case 'd':
+			dir = optarg;
+			break;
+		default:
+			usage(argv[0]);
+		}
+	}
+	if (!size_mb || file_pct < 0 || file_pct > 100 ||
+	    touch_pct < 0 || touch_pct > 100 || dirty < 0 || loops <= 0)
+		usage(argv[0]);
+	if (access(dir, W_OK))
+		dir = "/tmp";
+
+	page_size = sysconf(_SC_PAGESIZE);
+	file_len = (size_mb << 20) / 100 * file_pct & ~(page_size - 1);
+	anon_len = (size_mb << 20) - file_len;
+	touch_len = file_len / 100 * touch_pct;
+
+	file_map = file_len ? map_file(dir, file_len) : NULL;
+	anon_map = mmap(NULL, anon_len ? anon_len : page_size,
+			PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS,
+			-1, 0);
+	if (anon_map == MAP_FAILED)
+		die("mmap anon");
+
+	/* read the whole file mapping and dirty one page in @dirty */
+	touch(file_map, file_len, page_size, 0);
+	if (dirty)
+		touch(file_map, file_len, page_size * dirty, 1);
+	touch(anon_map, anon_len, page_size, 1);
+
+	printf("rss %zu MB: file %zu MB, anon %zu MB, child reads %d%%, "
+	       "dirty interval %d\n", size_mb, file_len >> 20, anon_len >> 20,
+	       touch_pct, dirty);
+
+	for (i = 0; i < loops; i++) {
+		double start, forked, done;
+		int status;
+		pid_t pid;
+
+		start = now_us();
+		pid = fork();
+		if (pid < 0)
+			die("fork");
+		if (!pid) {
+			touch(file_map, touch_len, page_size, 0);
+			_exit(0);
+		}
+		forked = now_us();
+		if (waitpid(pid, &status, 0) < 0)
+			die("waitpid");
+		done = now_us();
+
+		forked -= start;
+		if (forked < fork_min)
+			fork_min = forked;
+		if (forked > fork_max)
+			fork_max = forked;
+		fork_sum += forked;
+		child_sum += done - start;
+	}
+
+	printf("fork:        min %8.0f us  avg %8.0f us  max %8.0f us\n",
+	       fork_min, fork_sum / loops, fork_max);
+	printf("fork+child:  avg %8.0f us\n", child_sum / loops);
+	return 0;
+}